@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Measures the cost of reading each clock policy, and of a TimeStamper stamp using it.
+ */
+
+#include <soraxas_toolbox/clock.h>
+#include <soraxas_toolbox/stats/timer.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+constexpr size_t num_iterations = 10000000;
+// stamps are recorded in batches, such that a stamp is timed on a buffer of bounded size
+constexpr size_t batch_size = 10000;
+
+template <typename F>
+double time_per_iteration(const F &functor)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_iterations; ++i)
+        functor();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() /
+           num_iterations;
+}
+
+template <typename ClockPolicy>
+void bench_clock_policy(const std::string &name)
+{
+    const double now_cost =
+        time_per_iteration([]() { sxs::doNotOptimizeAway(ClockPolicy::now()); });
+
+    sxs::TimeStamper<int, ClockPolicy> stamper;
+    stamper.set_autoprint(false);
+    double stamp_time = 0;
+    for (size_t batch = 0; batch < num_iterations / batch_size; ++batch)
+    {
+        // keeps the capacity of the first batch, so later batches never grow it
+        stamper.reset();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < batch_size; ++i)
+        {
+            stamper.template stamp<0>();
+            stamper.template stamp<1>();
+        }
+        stamp_time +=
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    const double stamp_cost = stamp_time / num_iterations;
+
+    std::cout << std::left << std::setw(20) << name
+              << " now(): " << sxs::format_time2readable(now_cost)
+              << " stamp(): " << sxs::format_time2readable(stamp_cost / 2) << std::endl;
+}
+
+}  // namespace
+
+int main()
+{
+    bench_clock_policy<sxs::clock_policy::high_resolution>("high_resolution");
+    bench_clock_policy<sxs::clock_policy::steady>("steady");
+#ifdef SXS_HAS_POSIX_CLOCKS
+    bench_clock_policy<sxs::clock_policy::monotonic_raw>("monotonic_raw");
+    bench_clock_policy<sxs::clock_policy::monotonic_coarse>("monotonic_coarse");
+#endif
+#ifdef SXS_HAS_TSC_CLOCK
+    if (!sxs::clock_policy::tsc::is_invariant())
+        std::cout << "(tsc is not invariant on this cpu)" << std::endl;
+    bench_clock_policy<sxs::clock_policy::tsc>("tsc");
+#endif
+    return 0;
+}
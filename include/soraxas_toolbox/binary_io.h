@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sxs
+{
+namespace binary
+{
+
+/*
+ * Minimal helpers for compact binary files of plain values, in the byte order of the host.
+ * Reads throw std::runtime_error on a truncated stream.
+ */
+
+template <typename T>
+inline void write(std::ostream &stream, const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+inline T read(std::istream &stream)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+    T value;
+    if (!stream.read(reinterpret_cast<char *>(&value), sizeof(T)))
+        throw std::runtime_error("Unexpected end of binary stream");
+    return value;
+}
+
+inline void write_string(std::ostream &stream, const std::string &str)
+{
+    write<uint64_t>(stream, str.size());
+    stream.write(str.data(), str.size());
+}
+
+inline std::string read_string(std::istream &stream)
+{
+    std::string str(read<uint64_t>(stream), '\0');
+    if (!stream.read(&str[0], str.size()))
+        throw std::runtime_error("Unexpected end of binary stream");
+    return str;
+}
+
+template <typename T>
+inline void write_vector(std::ostream &stream, const std::vector<T> &values)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+    write<uint64_t>(stream, values.size());
+    stream.write(reinterpret_cast<const char *>(values.data()), sizeof(T) * values.size());
+}
+
+template <typename T>
+inline std::vector<T> read_vector(std::istream &stream)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+    std::vector<T> values(read<uint64_t>(stream));
+    if (!stream.read(reinterpret_cast<char *>(values.data()), sizeof(T) * values.size()))
+        throw std::runtime_error("Unexpected end of binary stream");
+    return values;
+}
+
+/*
+ * Write, or read and check, a magic tag and version at the start of a file.
+ */
+inline void write_magic(std::ostream &stream, const char (&magic)[8], uint32_t version)
+{
+    stream.write(magic, 8);
+    write(stream, version);
+}
+
+inline void read_magic(std::istream &stream, const char (&magic)[8], uint32_t version)
+{
+    char found[8];
+    if (!stream.read(found, 8) || std::string(found, 8) != std::string(magic, 8))
+        throw std::runtime_error("Not a " + std::string(magic, 7) + " binary stream");
+    if (read<uint32_t>(stream) != version)
+        throw std::runtime_error("Unsupported version of " + std::string(magic, 7));
+}
+
+}  // namespace binary
+}  // namespace sxs
@@ -0,0 +1,194 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SXS_CEREAL_STATS_H
+#define SXS_CEREAL_STATS_H
+
+#include "soraxas_toolbox/stats/timer.h"
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace cereal
+{
+
+// ==================================================
+// interned string tokens, stored as their string
+// ==================================================
+
+template <class Archive>
+std::string save_minimal(const Archive &, const sxs::InternedString &token)
+{
+    return token.str();
+}
+
+template <class Archive>
+void load_minimal(const Archive &, sxs::InternedString &token, const std::string &str)
+{
+    token = sxs::InternedString(str);
+}
+
+// ==================================================
+// compiled stamper results (Stats and LogHistogram serialise themselves)
+// ==================================================
+
+// tsl::ordered_map has a serialize() member of its own, which cereal would otherwise find as well
+template <class Archive, typename Token>
+struct specialize<
+    Archive, sxs::TimeStampCollection<Token>, cereal::specialization::non_member_load_save>
+{
+};
+
+template <class Archive, typename Token>
+void save(Archive &archive, const sxs::TimeStampCollection<Token> &collection)
+{
+    archive(make_size_tag(static_cast<size_type>(collection.size())));
+    for (auto &&item : collection)
+        archive(item.first, item.second);
+}
+
+template <class Archive, typename Token>
+void load(Archive &archive, sxs::TimeStampCollection<Token> &collection)
+{
+    size_type size;
+    archive(make_size_tag(size));
+    collection.clear();
+    for (size_type i = 0; i < size; ++i)
+    {
+        sxs::TimeStampCollectionKey<Token> key;
+        sxs::Stats<double> stats;
+        archive(key, stats);
+        collection.emplace(std::move(key), std::move(stats));
+    }
+}
+
+}  // namespace cereal
+
+namespace sxs
+{
+
+/*
+ * Save compiled stamper results as a baseline file, to be compared against later runs with
+ * print_baseline_comparison() (see soraxas_toolbox/stats/baseline.h).
+ */
+template <typename Token>
+void save_baseline(const std::string &filename, const TimeStampCollection<Token> &collection)
+{
+    std::ofstream ss(filename, std::ios::binary);
+    if (!ss)
+        throw std::runtime_error("Unable to open baseline file " + filename);
+    cereal::BinaryOutputArchive oarchive(ss);
+    oarchive(collection);
+}
+
+template <typename Token>
+TimeStampCollection<Token> load_baseline(const std::string &filename)
+{
+    std::ifstream ss(filename, std::ios::binary);
+    if (!ss)
+        throw std::runtime_error("Unable to open baseline file " + filename);
+    TimeStampCollection<Token> collection;
+    cereal::BinaryInputArchive iarchive(ss);
+    iarchive(collection);
+    return collection;
+}
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+namespace __sxs_cereal_stats
+{
+
+TEST_CASE("[sxs] Serialise compiled stamper results with cereal")
+{
+    sxs::TimeStampCollection<int> collection;
+    for (int i = 0; i < 20; ++i)
+        collection[{0, 1}].add(i);
+    collection[{1, 0}].enable_histogram();
+    for (int i = 0; i < 20; ++i)
+        collection[{1, 0}].add(2.5 * i);
+
+    std::stringstream ss;
+    {
+        cereal::BinaryOutputArchive oarchive(ss);
+        oarchive(collection);
+    }
+    sxs::TimeStampCollection<int> loaded;
+    {
+        cereal::BinaryInputArchive iarchive(ss);
+        iarchive(loaded);
+    }
+    REQUIRE(loaded.size() == collection.size());
+    // insertion order is kept
+    CHECK(loaded.begin()->first == std::make_pair(0, 1));
+    for (auto &&item : collection)
+    {
+        const auto &stats = loaded.at(item.first);
+        CHECK(stats.count == item.second.count);
+        CHECK(stats.min == item.second.min);
+        CHECK(stats.max == item.second.max);
+        CHECK(stats.mean() == doctest::Approx(item.second.mean()));
+        CHECK(stats.stdev() == doctest::Approx(item.second.stdev()));
+    }
+    const double median = collection.at({1, 0}).percentile(50);
+    CHECK(loaded.at({1, 0}).percentile(50) == doctest::Approx(median));
+
+    SUBCASE("baseline file with interned string tokens")
+    {
+        const std::string filename =
+            (std::filesystem::temp_directory_path() / "sxs_cereal_baseline_test.bin").string();
+        sxs::TimeStampCollection<sxs::InternedString> named;
+        named[{"begin", "end"}].add(1.5);
+        sxs::save_baseline(filename, named);
+        auto baseline = sxs::load_baseline<sxs::InternedString>(filename);
+        REQUIRE(baseline.size() == 1);
+        CHECK(baseline.begin()->first.first == sxs::InternedString("begin"));
+        CHECK(baseline.at({"begin", "end"}).sum == doctest::Approx(1.5));
+        std::remove(filename.c_str());
+    }
+}
+
+}  // namespace __sxs_cereal_stats
+#endif  // SXS_RUN_TESTS
+
+#endif  // SXS_CEREAL_STATS_H
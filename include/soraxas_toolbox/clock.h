@@ -28,23 +28,152 @@
 #pragma once
 
 #include "format.h"
+#include "main.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#if defined(__linux__)
+#define SXS_HAS_POSIX_CLOCKS
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define SXS_HAS_TSC_CLOCK
+#endif
 
 namespace sxs
 {
 
-class Timer
+/*
+ * Clock policies for Timer and TimeStampers.
+ *
+ * A policy is a std::chrono-like clock (now(), duration, time_point) whose time points store
+ * integer ticks, plus a static to_secs(duration) that is only needed when reporting.
+ */
+namespace clock_policy
+{
+    /*
+     * Adapts any std::chrono clock.
+     */
+    template <typename ChronoClock>
+    struct chrono : ChronoClock
+    {
+        static double to_secs(const typename ChronoClock::duration &duration)
+        {
+            return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+        }
+    };
+
+    using high_resolution = chrono<std::chrono::high_resolution_clock>;
+    using steady = chrono<std::chrono::steady_clock>;
+
+#ifdef SXS_HAS_POSIX_CLOCKS
+    /*
+     * Reads clock_gettime with the given clock id, in nanoseconds.
+     */
+    template <clockid_t ClockId>
+    struct posix
+    {
+        using rep = int64_t;
+        using period = std::nano;
+        using duration = std::chrono::duration<rep, period>;
+        using time_point = std::chrono::time_point<posix, duration>;
+        static constexpr bool is_steady = true;
+
+        inline static time_point now() noexcept
+        {
+            timespec ts;
+            clock_gettime(ClockId, &ts);
+            return time_point(duration(static_cast<rep>(ts.tv_sec) * 1000000000 + ts.tv_nsec));
+        }
+
+        static double to_secs(const duration &duration)
+        {
+            return duration.count() * 1e-9;
+        }
+    };
+
+    // not subject to NTP slewing
+    using monotonic_raw = posix<CLOCK_MONOTONIC_RAW>;
+    // cheapest to read, but only has the resolution of a scheduler tick (usually 1~4ms)
+    using monotonic_coarse = posix<CLOCK_MONOTONIC_COARSE>;
+#endif  // SXS_HAS_POSIX_CLOCKS
+
+#ifdef SXS_HAS_TSC_CLOCK
+    /*
+     * Reads the time-stamp counter, in cpu cycles.
+     *
+     * Only meaningful when the cpu has an invariant TSC (see is_invariant()). The cycles-to-seconds
+     * ratio is calibrated against the steady clock on first use of to_secs(); call
+     * secs_per_tick() at startup to pay for the calibration up front.
+     */
+    struct tsc
+    {
+        using rep = int64_t;
+        // placeholder period: a tick is a cycle, use to_secs() for conversion
+        using period = std::ratio<1>;
+        using duration = std::chrono::duration<rep, period>;
+        using time_point = std::chrono::time_point<tsc, duration>;
+        static constexpr bool is_steady = true;
+
+        inline static time_point now() noexcept
+        {
+            return time_point(duration(static_cast<rep>(__rdtsc())));
+        }
+
+        static double to_secs(const duration &duration)
+        {
+            return duration.count() * secs_per_tick();
+        }
+
+        static double secs_per_tick()
+        {
+            static const double secs_per_tick = calibrate();
+            return secs_per_tick;
+        }
+
+        static double
+        calibrate(std::chrono::microseconds calibration_time = std::chrono::milliseconds(20))
+        {
+            using steady_clock = std::chrono::steady_clock;
+            const auto start = steady_clock::now();
+            const auto start_tick = __rdtsc();
+            auto end = start;
+            while (end - start < calibration_time)
+                end = steady_clock::now();
+            const auto end_tick = __rdtsc();
+            return std::chrono::duration<double>(end - start).count() / (end_tick - start_tick);
+        }
+
+        static bool is_invariant()
+        {
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+                return false;
+            return edx & (1 << 8);
+        }
+    };
+#endif  // SXS_HAS_TSC_CLOCK
+
+    using default_clock = high_resolution;
+}  // namespace clock_policy
+
+template <typename ClockPolicy = clock_policy::default_clock>
+class TimerBase
 {
-    using FloatType = float;
+    using FloatType = double;
 
 protected:
-    typedef std::chrono::high_resolution_clock clock_;
-    typedef std::chrono::duration<FloatType, std::ratio<1>> second_;
-    clock_::time_point beg_;
+    typedef ClockPolicy clock_;
+    typename clock_::time_point beg_;
 
 public:
-    Timer() : beg_(clock_::now())
+    TimerBase() : beg_(clock_::now())
     {
     }
 
@@ -58,22 +187,24 @@ public:
         return timepoint_diff_to_secs(clock_::now() - beg_);
     }
 
-    inline static clock_::time_point get_timepoint()
+    inline static typename clock_::time_point get_timepoint()
     {
         return clock_::now();
     }
 
-    static FloatType timepoint_diff_to_secs(const clock_::duration &duration)
+    static FloatType timepoint_diff_to_secs(const typename clock_::duration &duration)
     {
-        return std::chrono::duration_cast<second_>(duration).count();
+        return clock_::to_secs(duration);
     }
 
-    static FloatType timepoint_diff_to_secs(const clock_::time_point &tp)
+    static FloatType timepoint_diff_to_secs(const typename clock_::time_point &tp)
     {
         return timepoint_diff_to_secs(get_timepoint() - tp);
     }
 };
 
+using Timer = TimerBase<>;
+
 /*
  * Given something callable, this function will call the callable while
  * throttling of only calling it every x second.
@@ -95,29 +226,101 @@ inline void throttle(const float every_x_second, const F &functor)
     }
 }
 
+/*
+ * The cost of taking a measurement, i.e., what an empty measurement measures.
+ */
+struct MeasurementOverhead
+{
+    // median of empty measurements, which is what gets subtracted
+    double overhead = 0;
+    // 99th percentile of empty measurements
+    double noise_floor = 0;
+
+    /*
+     * From the durations (in seconds) of many empty measurements.
+     */
+    static MeasurementOverhead from_samples(std::vector<double> samples)
+    {
+        if (samples.empty())
+            return {};
+        std::sort(samples.begin(), samples.end());
+        return {samples[samples.size() / 2], samples[samples.size() * 99 / 100]};
+    }
+
+    /*
+     * Whether a mean duration cannot be told apart from an empty measurement.
+     */
+    bool is_within_noise(double mean, bool overhead_subtracted) const
+    {
+        return mean <= (overhead_subtracted ? noise_floor - overhead : noise_floor);
+    }
+};
+
+/*
+ * Whether measured durations have the measurement overhead subtracted by default.
+ */
+inline bool &subtract_measurement_overhead()
+{
+    static bool subtract = false;
+    return subtract;
+}
+
+/*
+ * Time a single call, as done by timeit.
+ */
 template <typename Lambda>
-void timeit(const Lambda &lambda, const std::string title = "untitled")
+inline double timeit_once(const Lambda &lambda)
 {
     typedef std::chrono::high_resolution_clock clock_;
     typedef std::chrono::duration<double, std::ratio<1>> second_;
-    auto f = [&lambda]()
+    std::chrono::time_point<clock_> start = clock_::now();
+    doNotOptimizeAway(lambda());
+    return std::chrono::duration_cast<second_>(clock_::now() - start).count();
+}
+
+/*
+ * Overhead of timeit_once, calibrated with an empty call on first use.
+ */
+inline const MeasurementOverhead &timeit_overhead()
+{
+    static const MeasurementOverhead overhead = []()
     {
-        std::chrono::time_point<clock_> start = clock_::now();
-        doNotOptimizeAway(lambda());
-        return std::chrono::duration_cast<second_>(clock_::now() - start).count();
-    };
+        std::vector<double> samples(10000);
+        for (auto &&sample : samples)
+            sample = timeit_once([]() { return 0; });
+        return MeasurementOverhead::from_samples(std::move(samples));
+    }();
+    return overhead;
+}
+
+template <typename Lambda>
+void timeit(
+    const Lambda &lambda, const std::string title = "untitled",
+    bool subtract_overhead = subtract_measurement_overhead()
+)
+{
+    auto f = [&lambda]() { return timeit_once(lambda); };
 
     double _elapsed = 0;
     unsigned long loop_count = 0;
     double fastest, slowest;
-    auto print_message = [&loop_count, &title, &_elapsed, &fastest, &slowest]()
+    auto print_message = [&loop_count, &title, &_elapsed, &fastest, &slowest, subtract_overhead]()
     {
+        const MeasurementOverhead &overhead = timeit_overhead();
+        const double offset = subtract_overhead ? overhead.overhead : 0;
+        const double elapsed = std::max(_elapsed - offset * loop_count, 0.);
+        const double average = elapsed / static_cast<double>(loop_count);
         std::cout << "========================================" << std::endl;
         std::cout << "[" << title << "]: Loop: " << loop_count
-                  << " | Total time: " << sxs::format_time2readable(_elapsed) << " | Avg: "
-                  << sxs::format_time2readable(_elapsed / static_cast<double>(loop_count)) << " ("
-                  << sxs::format_time2readable(fastest) << " ~ "
-                  << sxs::format_time2readable(slowest) << ")" << std::endl;
+                  << " | Total time: " << sxs::format_time2readable(elapsed)
+                  << " | Avg: " << sxs::format_time2readable(average) << " ("
+                  << sxs::format_time2readable(std::max(fastest - offset, 0.)) << " ~ "
+                  << sxs::format_time2readable(std::max(slowest - offset, 0.)) << ")";
+        if (subtract_overhead)
+            std::cout << " | overhead " << sxs::format_time2readable(offset) << " subtracted";
+        if (overhead.is_within_noise(average, subtract_overhead))
+            std::cout << " | (within measurement noise)";
+        std::cout << std::endl;
         std::cout << "========================================" << std::endl;
     };
     // first time
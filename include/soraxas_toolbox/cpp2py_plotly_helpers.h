@@ -42,12 +42,8 @@ void stats_aggregate_to_boxplot(
     // assume all StatsAggregate within all_stats contains the same set of name
     assert(all_stats.size() > 0);
     // TODO: test they have same set of name
-    // extract stats names from data
-    std::vector<std::string> stats_names;
-    std::for_each(
-        all_stats[0].second.data.begin(), all_stats[0].second.data.end(),
-        [&stats_names](auto &&item) { stats_names.push_back(item.first); }
-    );
+    // extract stats names from data (or from summaries, see StatsAggregate::use_summaries)
+    const std::vector<std::string> stats_names = all_stats[0].second.keys();
 
     // create the container to pass to plotly template
     std::vector<Plotly::FigureTemplate::boxplot_datatype<double>> container;
@@ -61,12 +57,11 @@ void stats_aggregate_to_boxplot(
         // add all stats of this instance
         for (const std::string &stats_name : stats_names)
         {
-            auto iter = stats.data.find(stats_name);
-            if (iter == stats.data.end())
+            auto stats_vals = stats.values(stats_name);
+            if (stats_vals.empty())
                 throw std::runtime_error("Given StatsAggregate vector contains "
                                          "inconsistent stats.");
-            auto stats_vals = (*iter).second;
-            sxs::vec::extend(y, stats_vals);
+            y.insert(y.end(), stats_vals.begin(), stats_vals.end());
             label.insert(label.end(), stats_vals.size(), stats_name);
         }
         container.emplace_back(stats_instance, label, y);
@@ -30,8 +30,10 @@
 
 #include "vector_math.h"
 
+#include <array>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 namespace sxs
@@ -60,6 +62,9 @@ const std::pair<double, const char *> &get_si_unit_and_factor(double value)
         1e9,                                 //
         std::numeric_limits<double>::max(),  //
     };
+    // below the first range (e.g. zero or negative), which would underflow the search below
+    if (value < value_range[1])
+        return si_units[0];
     // binary search
     unsigned short left = 0, right = si_units.size() - 1;
     unsigned short m = 0;
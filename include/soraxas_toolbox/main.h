@@ -106,6 +106,11 @@ indexOf(const std::vector<T> &vector, const T &data, bool throw_exception = fals
 
 namespace sxs
 {
+/*
+ * Size used to pad per-thread data, such that two threads never write into the same cache line.
+ */
+constexpr std::size_t cache_line_size = 64;
+
 // template <class T> void doNotOptimizeAway(T &&datum) {
 //  asm volatile("" : "+r"(datum));
 //}
@@ -0,0 +1,251 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * Appends values of a single type to a 1-d numpy .npy file, as raw bytes through a buffered file
+ * stream (i.e. no formatting at all), such that it can be opened zero-copy with
+ * `np.load(filename, mmap_mode='r')`.
+ *
+ * The header is written up front with a fixed size, and rewritten with the final shape when the
+ * file is closed. Until then, numpy reads the file as empty.
+ */
+class NpyColumnWriter
+{
+public:
+    // a multiple of 64 as recommended, with room for the shape of any 64-bit length
+    static constexpr size_t header_size = 128;
+
+    /*
+     * The numpy dtype of an arithmetic type, e.g. '<f8' for a double on a little-endian host.
+     */
+    template <typename T>
+    static std::string dtype()
+    {
+        const uint16_t probe = 1;
+        const bool little_endian = *reinterpret_cast<const char *>(&probe) == 1;
+        return std::string(sizeof(T) == 1 ? "|" : little_endian ? "<" : ">") + kind<T>() +
+               std::to_string(sizeof(T));
+    }
+
+    /*
+     * The numpy kind of an arithmetic type, i.e. the character of its dtype after the byte order.
+     */
+    template <typename T>
+    static constexpr char kind()
+    {
+        static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be written");
+        return std::is_floating_point<T>::value ? 'f'
+               : std::is_same<T, bool>::value   ? 'b'
+               : std::is_signed<T>::value       ? 'i'
+                                                : 'u';
+    }
+
+    NpyColumnWriter(const std::string &filename, std::string dtype)
+      : stream_(filename, std::ios::binary | std::ios::trunc)
+      , dtype_(std::move(dtype))
+      , item_size_(std::stoul(dtype_.substr(2)))
+    {
+        if (!stream_)
+            throw std::runtime_error("Unable to open npy file " + filename);
+        write_header();
+    }
+
+    ~NpyColumnWriter()
+    {
+        close();
+    }
+
+    NpyColumnWriter(const NpyColumnWriter &) = delete;
+    NpyColumnWriter &operator=(const NpyColumnWriter &) = delete;
+
+    template <typename T>
+    inline void append(const T &value)
+    {
+        check_dtype<T>();
+        stream_.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        ++size_;
+    }
+
+    template <typename T>
+    void append(const T *values, size_t count)
+    {
+        check_dtype<T>();
+        stream_.write(reinterpret_cast<const char *>(values), sizeof(T) * count);
+        size_ += count;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    const std::string &dtype() const
+    {
+        return dtype_;
+    }
+
+    /*
+     * Rewrite the header with the final shape, and close the file.
+     */
+    void close()
+    {
+        if (!stream_.is_open())
+            return;
+        stream_.seekp(0);
+        write_header();
+        stream_.close();
+    }
+
+    /*
+     * A file name for a column name, with any character that may not be portable replaced.
+     */
+    static std::string filename_of(const std::string &column)
+    {
+        std::string filename = column;
+        for (auto &&c : filename)
+        {
+            const bool portable = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                                  (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.';
+            if (!portable)
+                c = '_';
+        }
+        return filename + ".npy";
+    }
+
+protected:
+    // values of another type would silently be reinterpreted by numpy, even of the same size
+    template <typename T>
+    inline void check_dtype() const
+    {
+        if (kind<T>() != dtype_[1] || sizeof(T) != item_size_)
+            throw std::runtime_error(
+                "Unable to append " + dtype<T>() + " values to a npy column of " + dtype_
+            );
+    }
+
+    void write_header()
+    {
+        std::string header = "\x93NUMPY";
+        // version 1.0, then the little-endian length of the rest of the header
+        header.push_back(1);
+        header.push_back(0);
+        header.push_back(static_cast<char>((header_size - 10) & 0xff));
+        header.push_back(static_cast<char>((header_size - 10) >> 8));
+        header += "{'descr': '" + dtype_ + "', 'fortran_order': False, 'shape': (" +
+                  std::to_string(size_) + ",), }";
+        header.append(header_size - 1 - header.size(), ' ');
+        header.push_back('\n');
+        stream_.write(header.data(), header.size());
+    }
+
+    std::ofstream stream_;
+    std::string dtype_;
+    size_t item_size_;
+    size_t size_ = 0;
+};
+
+/*
+ * Write a whole column at once.
+ */
+template <typename T>
+void save_npy(const std::string &filename, const std::vector<T> &values)
+{
+    NpyColumnWriter writer(filename, NpyColumnWriter::dtype<T>());
+    writer.append(values.data(), values.size());
+}
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+namespace __sxs_npy_writer
+{
+
+TEST_CASE("[sxs] Npy column writer")
+{
+    CHECK(sxs::NpyColumnWriter::dtype<double>() == "<f8");
+    CHECK(sxs::NpyColumnWriter::dtype<int>() == "<i4");
+    CHECK(sxs::NpyColumnWriter::dtype<uint8_t>() == "|u1");
+    CHECK(sxs::NpyColumnWriter::filename_of("loss/val 1") == "loss_val_1.npy");
+
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "sxs_npy_writer.npy").string();
+    {
+        sxs::NpyColumnWriter writer(filename, sxs::NpyColumnWriter::dtype<double>());
+        for (int i = 0; i < 1000; ++i)
+            writer.append(i * 0.5);
+        const double more[] = {-1, -2};
+        writer.append(more, 2);
+        CHECK(writer.size() == 1002);
+        CHECK_THROWS_AS(writer.append(int64_t(1)), const std::runtime_error &);
+        CHECK_THROWS_AS(writer.append(1.0f), const std::runtime_error &);
+        CHECK(writer.size() == 1002);
+    }
+
+    std::ifstream stream(filename, std::ios::binary);
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    const std::string content = ss.str();
+    REQUIRE(content.size() == sxs::NpyColumnWriter::header_size + 1002 * sizeof(double));
+    CHECK(content.rfind("\x93NUMPY", 0) == 0);
+    CHECK(content.find("'shape': (1002,)") != std::string::npos);
+    CHECK(content[sxs::NpyColumnWriter::header_size - 1] == '\n');
+
+    double value;
+    std::memcpy(
+        &value, content.data() + sxs::NpyColumnWriter::header_size + 3 * sizeof(double),
+        sizeof(double)
+    );
+    CHECK(value == 1.5);
+    std::memcpy(&value, content.data() + content.size() - sizeof(double), sizeof(double));
+    CHECK(value == -2);
+    std::filesystem::remove(filename);
+}
+
+}  // namespace __sxs_npy_writer
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,132 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * Reduce the items [0, n) in parallel: contiguous blocks of items are reduced concurrently by
+ * `leaf(first, last)`, and the partial results are then merged pairwise in a tree by
+ * `merge(into, from)`, a level at a time. Partials are only ever merged with the one that follows
+ * them, such that the result (including its order) is the same as a single leaf over all items.
+ *
+ * With n == 0, this is `leaf(0, 0)`.
+ */
+template <typename Leaf, typename Merge>
+auto parallel_block_reduce(size_t n, size_t num_workers, Leaf &&leaf, Merge &&merge)
+{
+    using Partial = std::decay_t<decltype(leaf(size_t(), size_t()))>;
+    if (n == 0)
+        return leaf(0, 0);
+    num_workers = std::max<size_t>(1, std::min(num_workers, n));
+    const size_t block_size = (n + num_workers - 1) / num_workers;
+    // rounding up the block size can leave the last workers without an item
+    const size_t num_blocks = (n + block_size - 1) / block_size;
+
+    std::vector<std::future<Partial>> futures;
+    for (size_t block = 1; block < num_blocks; ++block)
+    {
+        const size_t first = block * block_size;
+        const size_t last = std::min(first + block_size, n);
+        futures.push_back(
+            std::async(std::launch::async, [&leaf, first, last]() { return leaf(first, last); })
+        );
+    }
+    std::vector<Partial> partials;
+    partials.reserve(num_blocks);
+    // the first block runs on this thread
+    partials.push_back(leaf(0, std::min(block_size, n)));
+    for (auto &&future : futures)
+        partials.push_back(future.get());
+
+    // merge neighbouring pairs, a level at a time
+    for (size_t stride = 1; stride < partials.size(); stride *= 2)
+    {
+        std::vector<std::future<void>> merges;
+        for (size_t i = 0; i + stride < partials.size(); i += 2 * stride)
+        {
+            merges.push_back(std::async(
+                std::launch::async,
+                [&partials, &merge, i, stride]() { merge(partials[i], partials[i + stride]); }
+            ));
+        }
+        for (auto &&future : merges)
+            future.get();
+    }
+    return std::move(partials[0]);
+}
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <string>
+
+namespace __sxs_parallel
+{
+
+TEST_CASE("[sxs] Parallel block reduce")
+{
+    auto concat = [](size_t first, size_t last)
+    {
+        std::string partial;
+        for (size_t i = first; i < last; ++i)
+            partial += static_cast<char>('a' + i);
+        return partial;
+    };
+    auto append = [](std::string &into, const std::string &from) { into += from; };
+
+    // the order is kept, however many workers (including more than items)
+    for (size_t num_workers : {1, 2, 3, 7, 26, 100})
+        CHECK(
+            sxs::parallel_block_reduce(26, num_workers, concat, append) ==
+            "abcdefghijklmnopqrstuvwxyz"
+        );
+    // e.g. 10 items on 4 workers are blocks of 3, 3, 3 and 1
+    CHECK(sxs::parallel_block_reduce(10, 4, concat, append) == "abcdefghij");
+    // e.g. 5 items on 4 workers are blocks of 2, 2 and 1, which leaves a worker without items
+    CHECK(sxs::parallel_block_reduce(5, 4, concat, append) == "abcde");
+    CHECK(sxs::parallel_block_reduce(0, 4, concat, append).empty());
+}
+
+}  // namespace __sxs_parallel
+#endif  // SXS_RUN_TESTS
@@ -160,7 +160,7 @@ private:
 
 #ifdef WIN32
 // Initialize s_count on windows
-int Socket::s_count{0};
+inline int Socket::s_count{0};
 #endif
 
 ////////////////////////////////////////
@@ -356,14 +356,15 @@ private:
 
 ////////////////////////////////////////
 
-UDPClient::UDPClient(u_short port, const std::string &ip_address) : Socket(SocketType::TYPE_DGRAM)
+inline UDPClient::UDPClient(u_short port, const std::string &ip_address)
+  : Socket(SocketType::TYPE_DGRAM)
 {
     set_address(ip_address);
     set_port(port);
     log(LOG_DEBUG) << "UDP Client created." << std::endl;
 };
 
-ssize_t UDPClient::send_message(const std::string &message)
+inline ssize_t UDPClient::send_message(const std::string &message)
 {
     size_t message_length = message.length();
     return sendto(
@@ -372,14 +373,15 @@ ssize_t UDPClient::send_message(const std::string &message)
     );
 };
 
-UDPServer::UDPServer(u_short port, const std::string &ip_address) : Socket(SocketType::TYPE_DGRAM)
+inline UDPServer::UDPServer(u_short port, const std::string &ip_address)
+  : Socket(SocketType::TYPE_DGRAM)
 {
     set_port(port);
     set_address(ip_address);
     log(LOG_DEBUG) << "UDP Server created." << std::endl;
 }
 
-int UDPServer::socket_bind()
+inline int UDPServer::socket_bind()
 {
     if (bind(m_socket, reinterpret_cast<sockaddr *>(&m_addr), sizeof(m_addr)) == SOCKET_ERROR)
     {
@@ -391,7 +393,7 @@ int UDPServer::socket_bind()
     return 0;
 }
 
-void UDPServer::listen()
+inline void UDPServer::listen()
 {
     sockaddr_in client;
     char client_ip[INET_ADDRSTRLEN];
@@ -418,14 +420,15 @@ void UDPServer::listen()
     }
 }
 
-TCPClient::TCPClient(u_short port, const std::string &ip_address) : Socket(SocketType::TYPE_STREAM)
+inline TCPClient::TCPClient(u_short port, const std::string &ip_address)
+  : Socket(SocketType::TYPE_STREAM)
 {
     set_address(ip_address);
     set_port(port);
     log(LOG_DEBUG) << "TCP client created." << std::endl;
 }
 
-int TCPClient::make_connection()
+inline int TCPClient::make_connection()
 {
     log(LOG_DEBUG) << "Connecting" << std::endl;
     if (connect(m_socket, reinterpret_cast<sockaddr *>(&m_addr), sizeof(m_addr)) < 0)
@@ -438,7 +441,7 @@ int TCPClient::make_connection()
     return 0;
 }
 
-int TCPClient::send_message(const std::string &message)
+inline int TCPClient::send_message(const std::string &message)
 {
     char server_reply[2000];
     size_t length = message.length();
@@ -32,16 +32,42 @@
 #ifndef SXS_STATS_H
 #define SXS_STATS_H
 
+#include "soraxas_toolbox/binary_io.h"
+#include "soraxas_toolbox/clock.h"
+#include "soraxas_toolbox/external/concurrentqueue/blockingconcurrentqueue.h"
 #include "soraxas_toolbox/external/csv.hpp"
+#include "soraxas_toolbox/external/ordered-map/ordered_map.h"
 #include "soraxas_toolbox/future.h"
 #include "soraxas_toolbox/main.h"
-#include "soraxas_toolbox/timer.h"
+#include "soraxas_toolbox/npy_writer.h"
+#include "soraxas_toolbox/parallel.h"
+#include "soraxas_toolbox/stats/summary.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 
 #ifdef SXS_USE_PPRINT
 #include "soraxas_toolbox/external/pprint.hpp"
 #endif
 
 // #define SXS_STATS_BUILD_WITH_MUTEX
+// #define SXS_STATS_BUILD_WITH_SHARDS
+#if defined(SXS_STATS_BUILD_WITH_MUTEX) && defined(SXS_STATS_BUILD_WITH_SHARDS)
+#error "Stats can either be built with a mutex or with per-thread shards, but not both"
+#endif
 #ifdef SXS_STATS_BUILD_WITH_MUTEX
 #define SXS_STATS_MUTEX_LOCK m_data_lock.lock()
 #define SXS_STATS_MUTEX_UNLOCK m_data_lock.unlock()
@@ -57,9 +83,138 @@ using stats_internal_variant = std::variant<long, int, double, float>;
 using stats_aggregate_internal_variant =
     std::variant<std::vector<long>, std::vector<int>, std::vector<double>, std::vector<float>>;
 
+// read a raw value of the given alternative of stats_internal_variant
+template <size_t I = 0>
+stats_internal_variant read_stats_value(std::istream &stream, size_t index)
+{
+    if constexpr (I < std::variant_size_v<stats_internal_variant>)
+    {
+        if (index == I)
+            return binary::read<std::variant_alternative_t<I, stats_internal_variant>>(stream);
+        return read_stats_value<I + 1>(stream, index);
+    }
+    else
+        throw std::runtime_error("Unknown type of stats value " + std::to_string(index));
+}
+
+/*
+ * Writes csv rows on a background thread. The producer fills raw values into a row that is
+ * recycled from the ones already written, hands it over through a lock-free queue, and the writer
+ * thread formats and writes it to a buffered file. Rows are produced by a single thread at a time.
+ */
+class AsyncCSVWriter
+{
+public:
+    struct Row
+    {
+        std::optional<double> timestamp;
+        // only set for the first row, if a header is wanted
+        std::vector<std::string> header;
+        std::vector<stats_internal_variant> values;
+    };
+
+    AsyncCSVWriter(const std::string &filename, bool write_header = true, size_t num_rows = 64)
+      : stream_(filename), csv_(stream_), header_pending_(write_header)
+    {
+        for (size_t i = 0; i < num_rows; ++i)
+        {
+            rows_.push_back(std::make_unique<Row>());
+            free_rows_.enqueue(rows_.back().get());
+        }
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    /*
+     * Write all submitted rows, then stop the writer thread.
+     */
+    ~AsyncCSVWriter()
+    {
+        stopping_ = true;
+        thread_.join();
+    }
+
+    AsyncCSVWriter(const AsyncCSVWriter &) = delete;
+    AsyncCSVWriter &operator=(const AsyncCSVWriter &) = delete;
+
+    /*
+     * A row to fill, which only allocates if all preallocated rows are still waiting to be written.
+     */
+    Row *acquire_row()
+    {
+        Row *row;
+        if (free_rows_.try_dequeue(row))
+        {
+            row->header.clear();
+            row->values.clear();
+            return row;
+        }
+        rows_.push_back(std::make_unique<Row>());
+        return rows_.back().get();
+    }
+
+    void submit(Row *row)
+    {
+        pending_rows_.enqueue(row);
+    }
+
+    // true once, for the first row, if a header is wanted
+    bool take_header_pending()
+    {
+        return std::exchange(header_pending_, false);
+    }
+
+protected:
+    void run()
+    {
+        Row *row;
+        while (!stopping_)
+        {
+            if (pending_rows_.wait_dequeue_timed(row, std::chrono::milliseconds(50)))
+                write(row);
+        }
+        // rows submitted before stopping are all visible by now
+        while (pending_rows_.try_dequeue(row))
+            write(row);
+        stream_.flush();
+    }
+
+    void write(Row *row)
+    {
+        if (!row->header.empty())
+            csv_ << row->header;
+        cols_.clear();
+        if (row->timestamp)
+            cols_.push_back(std::to_string(*row->timestamp));
+        for (auto &&value : row->values)
+            std::visit([this](const auto &x) { cols_.push_back(std::to_string(x)); }, value);
+        csv_ << cols_;
+        free_rows_.enqueue(row);
+    }
+
+    std::ofstream stream_;
+    csv::CSVWriter<std::ofstream> csv_;
+    std::vector<std::string> cols_;
+    bool header_pending_;
+
+    // owns all rows, and only grows on the producer side
+    std::vector<std::unique_ptr<Row>> rows_;
+    moodycamel::BlockingConcurrentQueue<Row *> free_rows_;
+    moodycamel::BlockingConcurrentQueue<Row *> pending_rows_;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
 class Stats
 {
-    /* A class that stores stats for performing basic performance test */
+    /* A class that stores stats for performing basic performance test
+     *
+     * With SXS_STATS_BUILD_WITH_SHARDS, every thread updates its own shard of values (see
+     * of()), and reads (formatting, csv, StatsAggregate) sum the shards of all threads on demand.
+     * Hence updates never contend. However, values are updated through plain references without
+     * any lock, so reading (i.e. anything that merges the shards) while other threads update them
+     * is a data race, and is not allowed: read once the threads are done, or between the steps in
+     * which they update.
+     */
 public:
     Stats(bool initialise_timer = true)
     {
@@ -73,6 +228,10 @@ public:
         typename = std::enable_if_t<std::is_arithmetic<Numeric>::value, Numeric>>
     Numeric &of(const std::string &key)
     {
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+        // each thread has a reference of its own
+        return std::get<Numeric>(shard_value(key, (Numeric)0));
+#else
         SXS_STATS_MUTEX_LOCK;
         auto val_it = data.find(key);
         if (val_it != data.end())
@@ -89,16 +248,90 @@ public:
         SXS_STATS_MUTEX_UNLOCK;
 
         return val;
+#endif
+    }
+
+    /*
+     * A key that is resolved to its value once, for counters on a hot path: updating through a
+     * handle is a single add, rather than hashing the key and visiting the variant on every of().
+     * The key takes its place in the printing and csv column order when the handle is created.
+     *
+     * A handle stays valid across reset(), after which it re-registers its key on first use. With
+     * shards, a handle updates the shard of the thread that created it, and should only be used
+     * by that thread.
+     */
+    template <class Numeric>
+    class Handle
+    {
+    public:
+        Handle(Stats &stats, std::string key) : stats_(&stats), key_(std::move(key))
+        {
+            resolve();
+        }
+
+        inline Numeric &value()
+        {
+            if (generation_ != stats_->m_generation)
+                resolve();
+            return *value_;
+        }
+
+        inline Handle &operator+=(Numeric amount)
+        {
+            value() += amount;
+            return *this;
+        }
+
+        inline Handle &operator++()
+        {
+            ++value();
+            return *this;
+        }
+
+        inline void set(Numeric new_value)
+        {
+            value() = new_value;
+        }
+
+        const std::string &key() const
+        {
+            return key_;
+        }
+
+    private:
+        void resolve()
+        {
+            // values are never moved, as the ordered map is backed by a deque (and so are shards)
+            value_ = &stats_->of<Numeric>(key_);
+            generation_ = stats_->m_generation;
+        }
+
+        Stats *stats_;
+        std::string key_;
+        Numeric *value_;
+        uint64_t generation_;
+    };
+
+    template <
+        class Numeric = double,
+        typename = std::enable_if_t<std::is_arithmetic<Numeric>::value, Numeric>>
+    Handle<Numeric> handle(const std::string &key)
+    {
+        return Handle<Numeric>(*this, key);
     }
 
     // return the actual std::variant
     stats_internal_variant &get(const std::string &key)
     {
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+        return shard_value(key, stats_internal_variant());
+#else
         SXS_STATS_MUTEX_LOCK;
         auto &val = data[key];
         SXS_STATS_MUTEX_UNLOCK;
 
         return val;
+#endif
     }
 
     // nicely format the contained items to the input stream
@@ -108,17 +341,32 @@ public:
         // this works with anything that accepts << operator (and returns
         // itself)
         bool firstitem = true;
+        for_each_item(
+            [&](const std::string &key, const stats_internal_variant &value)
+            {
+                if (firstitem)
+                    firstitem = false;
+                else
+                    stream << ", ";
+                stream << key << ": ";
+                std::visit([&stream](const auto &x) { stream << x; }, value);
+            }
+        );
+    }
+
+    // visit every key and value, after summing the shards of all threads (if sharded)
+    template <typename F>
+    void for_each_item(F &&functor) const
+    {
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+        for (auto &&item : merged())
+            functor(item.first, item.second);
+#else
         SXS_STATS_MUTEX_LOCK;
         for (auto &&item : data)
-        {
-            if (firstitem)
-                firstitem = false;
-            else
-                stream << ", ";
-            stream << item.first << ": ";
-            std::visit([&stream](const auto &x) { stream << x; }, item.second);
-        }
+            functor(item.first, item.second);
         SXS_STATS_MUTEX_UNLOCK;
+#endif
     }
 
     operator std::string() const
@@ -126,7 +374,11 @@ public:
         std::stringstream ss;
 #ifdef SXS_USE_PPRINT
         pprint::PrettyPrinter printer(ss);
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+        printer.print(merged());
+#else
         printer.print(data);
+#endif
 #else
         ss << "{";
         format_item(ss);
@@ -143,8 +395,19 @@ public:
 
     void reset()
     {
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+        // references returned by of() are invalidated, so no thread may be updating
+        std::lock_guard<std::mutex> guard(m_shards_lock);
+        for (auto &&shard : m_shards)
+        {
+            std::lock_guard<std::mutex> shard_guard(shard->lock);
+            shard->index.clear();
+            shard->slots.clear();
+        }
+#endif
         SXS_STATS_MUTEX_LOCK;
         data.clear();
+        ++m_generation;
         SXS_STATS_MUTEX_UNLOCK;
     }
 
@@ -158,8 +421,20 @@ public:
         }
     }
 
-    void set_stats_output_file(const std::string &filename, bool write_header = true)
+    /*
+     * With async, serialise_to_csv() only copies the raw values, and a background thread formats
+     * and writes them (see AsyncCSVWriter).
+     */
+    void set_stats_output_file(
+        const std::string &filename, bool write_header = true, bool async = false
+    )
     {
+        close_stats_output_file();
+        if (async)
+        {
+            m_async_csv = std::make_unique<AsyncCSVWriter>(filename, write_header);
+            return;
+        }
         csv_output_file_stream = std::make_unique<std::ofstream>(filename);
         csv_output_file = std::make_unique<csv::CSVWriter<std::ofstream>>(*csv_output_file_stream);
         writer_stream_first_row_written = !write_header;
@@ -169,46 +444,272 @@ public:
     {
         /* this function assumes no new stat type is added, and the order
          * reutrned by the map iterator maintains a stable order. */
-        // write header row
+        if (m_async_csv)
+        {
+            serialise_to_csv_async(include_timestamp);
+            return;
+        }
+        // the header row is only built for the first row
+        const bool with_header = !writer_stream_first_row_written;
+        std::vector<std::string> header;
         std::vector<std::string> cols;
-        SXS_STATS_MUTEX_LOCK;
-        if (!writer_stream_first_row_written)
+        if (include_timestamp && m_timer)
         {
-            if (include_timestamp && m_timer)
-                cols.push_back("timestamp");
-            for (auto &&item : data)
+            if (with_header)
+                header.push_back("timestamp");
+            cols.push_back(std::to_string(m_timer->elapsed()));
+        }
+        for_each_item(
+            [&](const std::string &key, const stats_internal_variant &value)
             {
-                cols.push_back(item.first);
+                if (with_header)
+                    header.push_back(key);
+                std::visit([&cols](const auto &x) { cols.push_back(std::to_string(x)); }, value);
             }
+        );
+        // write header row
+        if (with_header)
+        {
             writer_stream_first_row_written = true;
-            (*csv_output_file) << cols;
-            cols.clear();
+            (*csv_output_file) << header;
         }
         // data row
+        (*csv_output_file) << cols;
+    }
+
+    /*
+     * Flush and close the csv output file, after all pending rows are written.
+     */
+    void close_stats_output_file()
+    {
+        m_async_csv.reset();
+        csv_output_file.reset();
+        csv_output_file_stream.reset();
+    }
+
+    /*
+     * Append rows to a .npy file per key (see NpyColumnWriter) within the given directory, as
+     * raw binary values rather than formatted text. Keys that first appear in a later row are
+     * padded with zeros, such that all columns stay aligned.
+     *
+     * This is independent of the csv output file, such that both can be written at once.
+     */
+    void set_stats_npy_directory(const std::string &directory)
+    {
+        close_stats_npy_directory();
+        std::filesystem::create_directories(directory);
+        m_npy_directory = directory;
+    }
+
+    /*
+     * Close the .npy files of the npy directory, with their final shapes.
+     */
+    void close_stats_npy_directory()
+    {
+        m_npy_columns.clear();
+        m_npy_directory.clear();
+        m_npy_rows = 0;
+    }
+
+    void serialise_to_npy(bool include_timestamp = true)
+    {
+        if (include_timestamp && m_timer)
+            npy_column("timestamp", double()).append(m_timer->elapsed());
+        for_each_item(
+            [this](const std::string &key, const stats_internal_variant &value)
+            { std::visit([this, &key](const auto &x) { npy_column(key, x).append(x); }, value); }
+        );
+        ++m_npy_rows;
+    }
+
+    void serialise_to_csv_async(bool include_timestamp = true)
+    {
+        AsyncCSVWriter::Row *row = m_async_csv->acquire_row();
+        const bool with_header = m_async_csv->take_header_pending();
+        row->timestamp.reset();
         if (include_timestamp && m_timer)
-            cols.push_back(std::to_string(m_timer->elapsed()));
-        for (auto &&item : data)
         {
-            std::visit([&cols](const auto &x) { cols.push_back(std::to_string(x)); }, item.second);
+            row->timestamp = m_timer->elapsed();
+            if (with_header)
+                row->header.push_back("timestamp");
+        }
+        for_each_item(
+            [&](const std::string &key, const stats_internal_variant &value)
+            {
+                if (with_header)
+                    row->header.push_back(key);
+                row->values.push_back(value);
+            }
+        );
+        m_async_csv->submit(row);
+    }
+
+    /*
+     * Write every key and its raw value in a compact binary form, e.g. for another process to
+     * combine with its own stats.
+     */
+    void save_binary(std::ostream &stream) const
+    {
+        std::vector<std::pair<std::string, stats_internal_variant>> items;
+        for_each_item(
+            [&items](const std::string &key, const stats_internal_variant &value)
+            { items.emplace_back(key, value); }
+        );
+        binary::write_magic(stream, "SXSSTAT", 1);
+        binary::write<uint64_t>(stream, items.size());
+        for (auto &&item : items)
+        {
+            binary::write_string(stream, item.first);
+            binary::write<uint8_t>(stream, static_cast<uint8_t>(item.second.index()));
+            std::visit([&stream](const auto &x) { binary::write(stream, x); }, item.second);
+        }
+    }
+
+    /*
+     * Set the keys saved by save_binary() to their saved values (and types).
+     */
+    void load_binary(std::istream &stream)
+    {
+        binary::read_magic(stream, "SXSSTAT", 1);
+        const auto num_items = binary::read<uint64_t>(stream);
+        for (uint64_t i = 0; i < num_items; ++i)
+        {
+            const std::string key = binary::read_string(stream);
+            const auto index = binary::read<uint8_t>(stream);
+            std::visit(
+                [this, &key](const auto &x) { of<std::decay_t<decltype(x)>>(key) = x; },
+                read_stats_value(stream, index)
+            );
         }
-        SXS_STATS_MUTEX_UNLOCK;
-        (*csv_output_file) << cols;
     }
 
     std::unique_ptr<sxs::Timer> m_timer;
     std::unique_ptr<std::ofstream> csv_output_file_stream;
     std::unique_ptr<csv::CSVWriter<std::ofstream>> csv_output_file;
+    std::unique_ptr<AsyncCSVWriter> m_async_csv;
+    std::string m_npy_directory;
+    std::unordered_map<std::string, std::unique_ptr<NpyColumnWriter>> m_npy_columns;
+    size_t m_npy_rows = 0;
+
+    // the column of a key, created (and padded to the current row) on first use
+    template <typename T>
+    NpyColumnWriter &npy_column(const std::string &key, const T &)
+    {
+        auto column = m_npy_columns.find(key);
+        if (column != m_npy_columns.end())
+            return *column->second;
+        auto writer = std::make_unique<NpyColumnWriter>(
+            (std::filesystem::path(m_npy_directory) / NpyColumnWriter::filename_of(key)).string(),
+            NpyColumnWriter::dtype<T>()
+        );
+        for (size_t i = 0; i < m_npy_rows; ++i)
+            writer->append(T());
+        return *m_npy_columns.emplace(key, std::move(writer)).first->second;
+    }
     bool writer_stream_first_row_written;
 
+    // with shards, only the keys (in order of first appearance) and zero of their type
     tsl::ordered_map<std::string, stats_internal_variant> data;
+    // bumped by every reset(), which invalidates the references held by handles
+    uint64_t m_generation = 0;
 #ifdef SXS_STATS_BUILD_WITH_MUTEX
     mutable std::mutex m_data_lock;
 #endif
+
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+    /*
+     * Sum of the values of all threads, which must not be updating them meanwhile. The locks only
+     * guard the keys of the shards, not their values.
+     */
+    tsl::ordered_map<std::string, stats_internal_variant> merged() const
+    {
+        std::lock_guard<std::mutex> guard(m_shards_lock);
+        auto result = data;
+        for (auto &&shard : m_shards)
+        {
+            std::lock_guard<std::mutex> shard_guard(shard->lock);
+            for (auto &&item : shard->index)
+            {
+                auto &total = result[item.first];
+                std::visit(
+                    [&total](const auto &x) { std::visit([&x](auto &t) { t += x; }, total); },
+                    shard->slots[item.second].value
+                );
+            }
+        }
+        return result;
+    }
+
+protected:
+    /*
+     * The values of a single thread. Each value has a cache line of its own, so that threads never
+     * write to a shared line. The owner looks its values up without locking, and only locks to add
+     * a value, as that races with the readers that merge shards.
+     */
+    struct Shard
+    {
+        struct alignas(64) Slot
+        {
+            stats_internal_variant value;
+        };
+
+        std::mutex lock;
+        std::unordered_map<std::string, size_t> index;
+        // never moves its elements, so references returned by of() stay valid
+        std::deque<Slot> slots;
+    };
+
+    Shard &thread_shard()
+    {
+        thread_local std::unordered_map<uint64_t, Shard *> shards;
+        auto it = shards.find(m_instance_id);
+        if (it != shards.end())
+            return *it->second;
+
+        std::lock_guard<std::mutex> guard(m_shards_lock);
+        m_shards.push_back(std::make_unique<Shard>());
+        shards.emplace(m_instance_id, m_shards.back().get());
+        return *m_shards.back();
+    }
+
+    stats_internal_variant &shard_value(const std::string &key, stats_internal_variant zero)
+    {
+        Shard &shard = thread_shard();
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+            return shard.slots[it->second].value;
+
+        {
+            std::lock_guard<std::mutex> guard(m_shards_lock);
+            data.emplace(key, zero);
+        }
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.index.emplace(key, shard.slots.size());
+        shard.slots.push_back({zero});
+        return shard.slots.back().value;
+    }
+
+    static uint64_t next_instance_id()
+    {
+        static std::atomic<uint64_t> next_id{0};
+        return next_id++;
+    }
+
+    // thread-local lookups are keyed by an id, as a destroyed instance's address can be reused
+    const uint64_t m_instance_id = next_instance_id();
+    mutable std::mutex m_shards_lock;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+#endif
 };
 
 class StatsAggregate
 {
-    /* Given the Stats object, aggregate results into a std list */
+    /* Given the Stats object, aggregate results into a std list
+     *
+     * With use_summaries(), each key keeps a fixed-size StreamingSummary (moments, a t-digest and
+     * an optional reservoir sample) rather than every value, such that memory stays bounded
+     * however many times stats are appended.
+     */
 public:
     StatsAggregate() = default;
 
@@ -217,24 +718,223 @@ public:
         append(stats);
     }
 
-    void append(const Stats &stats)
+    /*
+     * Summarise values from now on. Must be called before anything is appended.
+     */
+    void use_summaries(size_t reservoir_size = 256, double compression = 100)
+    {
+        assert(data.empty() && summaries.empty());
+        m_use_summaries = true;
+        m_reservoir_size = reservoir_size;
+        m_compression = compression;
+    }
+
+    bool is_using_summaries() const
     {
-        for (auto &&item : stats.data)
+        return m_use_summaries;
+    }
+
+    void add(const std::string &key, double value)
+    {
+        if (!m_use_summaries)
         {
-            // always push the item as a double (easier...)
-            // this will always down-cast int/long/float within Stats to
-            // double
-            std::visit(
-                [this, &item](const auto &x) { data[item.first].push_back(x); }, item.second
+            data[key].push_back(value);
+            return;
+        }
+        auto summary = summaries.find(key);
+        if (summary == summaries.end())
+        {
+            summary =
+                summaries.emplace(key, StreamingSummary(m_reservoir_size, m_compression)).first;
+        }
+        summary.value().add(value);
+    }
+
+    /*
+     * Merge another aggregate (e.g. of another worker) of the same mode into this one.
+     */
+    void merge(const StatsAggregate &other)
+    {
+        assert(m_use_summaries == other.m_use_summaries);
+        for (auto &&item : other.data)
+        {
+            auto &column = data[item.first];
+            column.insert(column.end(), item.second.begin(), item.second.end());
+        }
+        for (auto &&item : other.summaries)
+        {
+            auto summary = summaries.find(item.first);
+            if (summary == summaries.end())
+                summaries.emplace(item.first, item.second);
+            else
+                summary.value().merge(item.second);
+        }
+    }
+
+    std::vector<std::string> keys() const
+    {
+        std::vector<std::string> result;
+        if (m_use_summaries)
+            for (auto &&item : summaries)
+                result.push_back(item.first);
+        else
+            for (auto &&item : data)
+                result.push_back(item.first);
+        return result;
+    }
+
+    /*
+     * All values of a key, or values that stand for them when summarised (see
+     * StreamingSummary::representative_values()), e.g. for a box plot.
+     */
+    std::vector<double> values(const std::string &key) const
+    {
+        if (m_use_summaries)
+        {
+            auto summary = summaries.find(key);
+            return summary == summaries.end() ? std::vector<double>()
+                                              : summary->second.representative_values();
+        }
+        auto column = data.find(key);
+        return column == data.end() ? std::vector<double>() : column->second;
+    }
+
+    /*
+     * Write every column as a .npy file (see NpyColumnWriter) within the given directory.
+     */
+    void save_npy(const std::string &directory) const
+    {
+        std::filesystem::create_directories(directory);
+        for (auto &&key : keys())
+            sxs::save_npy(
+                (std::filesystem::path(directory) / NpyColumnWriter::filename_of(key)).string(),
+                values(key)
             );
+    }
+
+    /*
+     * Write the mode and every column (or summary) in a compact binary form.
+     */
+    void save_binary(std::ostream &stream) const
+    {
+        binary::write_magic(stream, "SXSAGGR", 1);
+        binary::write<uint8_t>(stream, m_use_summaries);
+        binary::write<uint64_t>(stream, m_reservoir_size);
+        binary::write(stream, m_compression);
+        binary::write<uint64_t>(stream, data.size());
+        for (auto &&item : data)
+        {
+            binary::write_string(stream, item.first);
+            binary::write_vector(stream, item.second);
+        }
+        binary::write<uint64_t>(stream, summaries.size());
+        for (auto &&item : summaries)
+        {
+            binary::write_string(stream, item.first);
+            item.second.save_binary(stream);
+        }
+    }
+
+    /*
+     * Replace the content (and mode) with the one saved by save_binary().
+     */
+    void load_binary(std::istream &stream)
+    {
+        binary::read_magic(stream, "SXSAGGR", 1);
+        m_use_summaries = binary::read<uint8_t>(stream);
+        m_reservoir_size = binary::read<uint64_t>(stream);
+        m_compression = binary::read<double>(stream);
+        data.clear();
+        summaries.clear();
+        const auto num_columns = binary::read<uint64_t>(stream);
+        for (uint64_t i = 0; i < num_columns; ++i)
+        {
+            std::string key = binary::read_string(stream);
+            data.emplace(std::move(key), binary::read_vector<double>(stream));
+        }
+        const auto num_summaries = binary::read<uint64_t>(stream);
+        for (uint64_t i = 0; i < num_summaries; ++i)
+        {
+            std::string key = binary::read_string(stream);
+            StreamingSummary summary;
+            summary.load_binary(stream);
+            summaries.emplace(std::move(key), std::move(summary));
         }
     }
 
+    /*
+     * Save as a shard file, e.g. one per worker process, to be combined by merge_shard_files().
+     */
+    void save_shard(const std::string &filename) const
+    {
+        std::ofstream stream(filename, std::ios::binary);
+        if (!stream)
+            throw std::runtime_error("Unable to open stats shard " + filename);
+        save_binary(stream);
+    }
+
+    static StatsAggregate load_shard(const std::string &filename)
+    {
+        std::ifstream stream(filename, std::ios::binary);
+        if (!stream)
+            throw std::runtime_error("Unable to open stats shard " + filename);
+        StatsAggregate aggregate;
+        aggregate.load_binary(stream);
+        return aggregate;
+    }
+
+    /*
+     * Load and merge shard files (of the same mode) with a parallel reduction (see
+     * parallel_block_reduce()): contiguous blocks of files are loaded and merged by the workers,
+     * then neighbouring blocks are merged a level at a time. The order of the files is kept, such that the columns of shards that each hold a
+     * consecutive part of a run equal the ones of a single aggregate over the whole run.
+     */
+    static StatsAggregate merge_shard_files(
+        const std::vector<std::string> &filenames,
+        size_t num_workers = std::max(1u, std::thread::hardware_concurrency())
+    )
+    {
+        if (filenames.empty())
+            return StatsAggregate();
+        return parallel_block_reduce(
+            filenames.size(), num_workers,
+            [&filenames](size_t first, size_t last)
+            {
+                StatsAggregate partial = load_shard(filenames[first]);
+                for (size_t i = first + 1; i < last; ++i)
+                    partial.merge(load_shard(filenames[i]));
+                return partial;
+            },
+            [](StatsAggregate &into, const StatsAggregate &from) { into.merge(from); }
+        );
+    }
+
+    void append(const Stats &stats)
+    {
+        stats.for_each_item(
+            [this](const std::string &key, const stats_internal_variant &value)
+            {
+                // always push the item as a double (easier...)
+                // this will always down-cast int/long/float within Stats to
+                // double
+                std::visit([this, &key](const auto &x) { add(key, x); }, value);
+            }
+        );
+    }
+
     operator std::string() const
     {
         bool firstitem = true;
         std::stringstream ss;
         ss << "{";
+        for (auto &&item : summaries)
+        {
+            if (firstitem)
+                firstitem = false;
+            else
+                ss << ", ";
+            ss << item.first << ":" << std::string(item.second);
+        }
         for (auto &&item : data)
         {
             if (firstitem)
@@ -266,8 +966,549 @@ public:
     }
 
     tsl::ordered_map<std::string, std::vector<double>> data;
+    tsl::ordered_map<std::string, StreamingSummary> summaries;
+
+protected:
+    bool m_use_summaries = false;
+    size_t m_reservoir_size = 0;
+    double m_compression = 100;
+};
+
+class StatsHistory
+{
+    /* Periodic snapshots of a Stats, kept in memory as a round-robin database
+     *
+     * Every resolution is a fixed-size ring of buckets, each of which consolidates `steps`
+     * consecutive snapshots into the min, max and mean of every key. The finest resolution (with
+     * a step of 1) keeps the raw snapshots, and coarser ones keep older trends, e.g., the defaults
+     * keep 10min of snapshots taken every second, 1h of 10s buckets and 24h of 1min buckets. The
+     * memory is bounded by the capacities and the number of keys, however long it runs.
+     */
+public:
+    struct Resolution
+    {
+        size_t steps;
+        size_t capacity;
+    };
+
+    // buckets of a key, from the oldest to the newest, where time is that of the first snapshot,
+    // and the newest may still be filling up (i.e. with fewer than `steps` snapshots so far)
+    struct Series
+    {
+        std::vector<double> time;
+        std::vector<double> min;
+        std::vector<double> max;
+        std::vector<double> mean;
+    };
+
+    /*
+     * Resolutions are given from the finest to the coarsest.
+     */
+    explicit StatsHistory(
+        std::vector<Resolution> resolutions = {{1, 600}, {10, 360}, {60, 1440}}
+    )
+    {
+        for (auto &&resolution : resolutions)
+        {
+            assert(resolution.steps > 0 && resolution.capacity > 0);
+            m_levels.emplace_back(resolution);
+        }
+    }
+
+    /*
+     * Take a snapshot of the current values, at the seconds elapsed since this was created.
+     */
+    void snapshot(const Stats &stats)
+    {
+        snapshot(stats, m_timer.elapsed());
+    }
+
+    void snapshot(const Stats &stats, double time)
+    {
+        std::vector<std::pair<std::string, double>> values;
+        stats.for_each_item(
+            [&values](const std::string &key, const stats_internal_variant &value)
+            {
+                std::visit(
+                    [&values, &key](const auto &x) { values.emplace_back(key, x); }, value
+                );
+            }
+        );
+
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_latest_time = time;
+        for (auto &&level : m_levels)
+            level.add(values, time);
+    }
+
+    size_t num_resolutions() const
+    {
+        return m_levels.size();
+    }
+
+    std::vector<std::string> keys() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        std::vector<std::string> result;
+        for (auto &&level : m_levels)
+            for (auto &&column : level.columns)
+                if (std::find(result.begin(), result.end(), column.first) == result.end())
+                    result.push_back(column.first);
+        return result;
+    }
+
+    /*
+     * All buckets of a key at the given resolution.
+     */
+    Series series(const std::string &key, size_t resolution = 0) const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_levels.at(resolution).series(key, std::numeric_limits<double>::lowest());
+    }
+
+    /*
+     * Buckets of a key over the last `duration` seconds (up to the latest snapshot), at the finest
+     * resolution that still reaches back that far, or otherwise the one that reaches back the
+     * furthest.
+     */
+    Series query(const std::string &key, double duration) const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (!m_latest_time)
+            return Series();
+        const double since = *m_latest_time - duration;
+        const Level *chosen = &m_levels.front();
+        for (auto &&level : m_levels)
+        {
+            if (level.oldest_time() < chosen->oldest_time())
+                chosen = &level;
+            if (level.covers(since))
+            {
+                chosen = &level;
+                break;
+            }
+        }
+        return chosen->series(key, since);
+    }
+
+protected:
+    struct Level
+    {
+        // a ring of buckets per key, which are NaN where the key had no value
+        struct Column
+        {
+            std::vector<double> min, max, mean;
+            // of the bucket being filled
+            double pending_min = std::numeric_limits<double>::max();
+            double pending_max = std::numeric_limits<double>::lowest();
+            double pending_sum = 0;
+            size_t pending_count = 0;
+        };
+
+        explicit Level(const Resolution &resolution)
+          : steps(resolution.steps), capacity(resolution.capacity), time(resolution.capacity)
+        {
+        }
+
+        void add(const std::vector<std::pair<std::string, double>> &values, double at)
+        {
+            if (pending_count == 0)
+                pending_time = at;
+            for (auto &&value : values)
+            {
+                auto column = columns.find(value.first);
+                if (column == columns.end())
+                {
+                    const double nan = std::numeric_limits<double>::quiet_NaN();
+                    column = columns.emplace(value.first, Column()).first;
+                    column.value().min.assign(capacity, nan);
+                    column.value().max.assign(capacity, nan);
+                    column.value().mean.assign(capacity, nan);
+                }
+                auto &c = column.value();
+                c.pending_min = std::min(c.pending_min, value.second);
+                c.pending_max = std::max(c.pending_max, value.second);
+                c.pending_sum += value.second;
+                ++c.pending_count;
+            }
+            if (++pending_count == steps)
+                consolidate();
+        }
+
+        void consolidate()
+        {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            for (auto column = columns.begin(); column != columns.end(); ++column)
+            {
+                auto &c = column.value();
+                c.min[head] = c.pending_count ? c.pending_min : nan;
+                c.max[head] = c.pending_count ? c.pending_max : nan;
+                c.mean[head] = c.pending_count ? c.pending_sum / c.pending_count : nan;
+                c.pending_min = std::numeric_limits<double>::max();
+                c.pending_max = std::numeric_limits<double>::lowest();
+                c.pending_sum = 0;
+                c.pending_count = 0;
+            }
+            time[head] = pending_time;
+            head = (head + 1) % capacity;
+            size = std::min(size + 1, capacity);
+            pending_count = 0;
+        }
+
+        // the consolidated buckets, then the pending one if it has any snapshot
+        size_t num_buckets() const
+        {
+            return size + (pending_count > 0);
+        }
+
+        size_t index_of(size_t bucket) const
+        {
+            return (head + capacity - size + bucket) % capacity;
+        }
+
+        double time_of(size_t bucket) const
+        {
+            return bucket < size ? time[index_of(bucket)] : pending_time;
+        }
+
+        double oldest_time() const
+        {
+            return num_buckets() == 0 ? std::numeric_limits<double>::max() : time_of(0);
+        }
+
+        // whether this has every bucket since the given time
+        bool covers(double since) const
+        {
+            return num_buckets() > 0 && (oldest_time() <= since || size < capacity);
+        }
+
+        Series series(const std::string &key, double since) const
+        {
+            Series result;
+            auto column = columns.find(key);
+            if (column == columns.end())
+                return result;
+            const Column &c = column->second;
+            // start from the bucket that contains `since`
+            size_t first = 0;
+            while (first + 1 < num_buckets() && time_of(first + 1) <= since)
+                ++first;
+            for (size_t i = first; i < num_buckets(); ++i)
+            {
+                result.time.push_back(time_of(i));
+                if (i < size)
+                {
+                    const size_t index = index_of(i);
+                    result.min.push_back(c.min[index]);
+                    result.max.push_back(c.max[index]);
+                    result.mean.push_back(c.mean[index]);
+                }
+                else
+                {
+                    const double nan = std::numeric_limits<double>::quiet_NaN();
+                    result.min.push_back(c.pending_count ? c.pending_min : nan);
+                    result.max.push_back(c.pending_count ? c.pending_max : nan);
+                    result.mean.push_back(c.pending_count ? c.pending_sum / c.pending_count : nan);
+                }
+            }
+            return result;
+        }
+
+        size_t steps;
+        size_t capacity;
+        size_t head = 0;
+        size_t size = 0;
+        size_t pending_count = 0;
+        double pending_time = 0;
+        std::vector<double> time;
+        tsl::ordered_map<std::string, Column> columns;
+    };
+
+    sxs::Timer m_timer;
+    mutable std::mutex m_lock;
+    std::optional<double> m_latest_time;
+    // from the finest to the coarsest
+    std::vector<Level> m_levels;
 };
 
 }  // namespace sxs
 
 #endif  // SXS_STATS_H
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace __sxs_stats
+{
+
+TEST_CASE("[sxs] Stats counters")
+{
+    sxs::Stats stats(false);
+    stats.of("iterations") += 3;
+    stats.of<int>("failures") += 1;
+    stats.of("iterations") += 2;
+    CHECK(std::string(stats) == "{iterations: 5, failures: 1}");
+
+    sxs::StatsAggregate aggregate(stats);
+    aggregate.append(stats);
+    CHECK(aggregate.get().at("iterations") == std::vector<double>{5, 5});
+
+    SUBCASE("pre-registered handles")
+    {
+        auto hits = stats.handle<long>("hits");
+        auto ratio = stats.handle("ratio");
+        for (int i = 0; i < 10; ++i)
+            ++hits;
+        hits += 5;
+        ratio.set(0.5);
+        CHECK(hits.value() == 15);
+        CHECK(stats.of<long>("hits") == 15);
+        // keys keep the order in which they were registered
+        CHECK(std::string(stats) == "{iterations: 5, failures: 1, hits: 15, ratio: 0.5}");
+
+        stats.reset();
+        ++hits;
+        CHECK(std::string(stats) == "{hits: 1}");
+    }
+
+    SUBCASE("asynchronous csv rows equal synchronous ones")
+    {
+        const auto directory = std::filesystem::temp_directory_path();
+        const std::string sync_file = (directory / "sxs_stats_sync.csv").string();
+        const std::string async_file = (directory / "sxs_stats_async.csv").string();
+        auto read_file = [](const std::string &filename)
+        {
+            std::ifstream stream(filename);
+            std::stringstream ss;
+            ss << stream.rdbuf();
+            return ss.str();
+        };
+
+        for (bool async : {false, true})
+        {
+            stats.reset();
+            stats.set_stats_output_file(async ? async_file : sync_file, true, async);
+            for (int i = 0; i < 200; ++i)
+            {
+                stats.of("iterations") += 1;
+                stats.of<int>("failures") = i % 3;
+                stats.serialise_to_csv(false);
+            }
+            stats.close_stats_output_file();
+        }
+        const std::string written = read_file(async_file);
+        CHECK(written == read_file(sync_file));
+        CHECK(written.rfind("iterations,failures\n1.000000,0\n", 0) == 0);
+        std::filesystem::remove(sync_file);
+        std::filesystem::remove(async_file);
+    }
+
+    SUBCASE("binary npy columns")
+    {
+        const auto directory = std::filesystem::temp_directory_path() / "sxs_stats_npy";
+        const auto csv_file = directory / "alongside.csv";
+        stats.set_stats_npy_directory(directory.string());
+        stats.set_stats_output_file(csv_file.string());
+        sxs::StatsAggregate aggregate;
+        for (int i = 0; i < 10; ++i)
+        {
+            stats.of("iterations") += 1;
+            if (i >= 4)
+                stats.of<int>("late") = i;
+            stats.serialise_to_npy(false);
+            stats.serialise_to_csv(false);
+            aggregate.append(stats);
+        }
+        // closing either output leaves the other one open
+        stats.close_stats_output_file();
+        stats.serialise_to_npy(false);
+        stats.close_stats_npy_directory();
+        CHECK(std::filesystem::file_size(csv_file) > 0);
+        aggregate.save_npy((directory / "aggregate").string());
+
+        // header + values, where the late column is padded
+        const auto header_size = sxs::NpyColumnWriter::header_size;
+        CHECK(std::filesystem::file_size(directory / "iterations.npy") == header_size + 11 * 8);
+        CHECK(std::filesystem::file_size(directory / "late.npy") == header_size + 11 * 4);
+        CHECK(
+            std::filesystem::file_size(directory / "aggregate" / "late.npy") ==
+            header_size + 6 * 8
+        );
+        std::filesystem::remove_all(directory);
+    }
+
+    SUBCASE("bounded-memory summaries")
+    {
+        sxs::StatsAggregate summarised, other;
+        summarised.use_summaries(16);
+        other.use_summaries(16);
+        for (int i = 0; i < 10000; ++i)
+        {
+            stats.of("iterations") = i;
+            (i % 2 ? summarised : other).append(stats);
+        }
+        summarised.merge(other);
+
+        const auto &summary = summarised.summaries.at("iterations");
+        CHECK(summary.count() == 10000);
+        CHECK(summary.mean() == doctest::Approx(4999.5));
+        CHECK(summary.quantile(0.5) == doctest::Approx(5000).epsilon(0.01));
+        CHECK(summarised.keys() == std::vector<std::string>{"iterations", "failures"});
+        CHECK(summarised.values("iterations").size() == 16);
+        CHECK(std::string(summarised).rfind("{iterations:{n=10000, mean=4999.5", 0) == 0);
+    }
+
+    SUBCASE("merged shard files equal a single aggregate")
+    {
+        const auto directory = std::filesystem::temp_directory_path() / "sxs_stats_shards";
+        std::filesystem::create_directories(directory);
+        for (bool summarised : {false, true})
+        {
+            sxs::StatsAggregate single;
+            std::vector<sxs::StatsAggregate> shards(5);
+            if (summarised)
+            {
+                single.use_summaries(16);
+                for (auto &&shard : shards)
+                    shard.use_summaries(16);
+            }
+            for (int i = 0; i < 1000; ++i)
+            {
+                stats.of("iterations") = i;
+                stats.of<int>("failures") = i % 7;
+                single.append(stats);
+                // every shard holds a consecutive part of the run
+                shards[i / 200].append(stats);
+            }
+            std::vector<std::string> filenames;
+            for (size_t i = 0; i < shards.size(); ++i)
+            {
+                filenames.push_back((directory / (std::to_string(i) + ".bin")).string());
+                shards[i].save_shard(filenames.back());
+            }
+
+            for (size_t num_workers : {1, 2, 4})
+            {
+                auto merged = sxs::StatsAggregate::merge_shard_files(filenames, num_workers);
+                CHECK(merged.is_using_summaries() == summarised);
+                CHECK(merged.keys() == single.keys());
+                if (!summarised)
+                {
+                    for (auto &&key : single.keys())
+                        CHECK(merged.values(key) == single.values(key));
+                }
+                else
+                {
+                    const auto &summary = merged.summaries.at("iterations");
+                    const auto &expected = single.summaries.at("iterations");
+                    CHECK(summary.count() == expected.count());
+                    CHECK(summary.mean() == doctest::Approx(expected.mean()));
+                    CHECK(summary.stdev() == doctest::Approx(expected.stdev()));
+                    CHECK(summary.quantile(0.5) == doctest::Approx(expected.quantile(0.5)));
+                    CHECK(summary.reservoir().samples().size() == 16);
+                }
+            }
+        }
+        CHECK_THROWS_AS(
+            sxs::StatsAggregate::load_shard((directory / "missing.bin").string()),
+            const std::runtime_error &
+        );
+
+        std::stringstream stream;
+        stats.save_binary(stream);
+        sxs::Stats loaded(false);
+        loaded.load_binary(stream);
+        CHECK(std::string(loaded) == std::string(stats));
+        loaded.reset();
+        std::filesystem::remove_all(directory);
+    }
+
+    SUBCASE("history downsampled into coarser resolutions")
+    {
+        sxs::StatsHistory history({{1, 10}, {5, 10}, {25, 10}});
+        for (int i = 0; i < 100; ++i)
+        {
+            stats.of("iterations") = i;
+            if (i >= 50)
+                stats.of<int>("late") = 2 * i;
+            history.snapshot(stats, i);
+        }
+        CHECK(history.keys() == std::vector<std::string>{"iterations", "failures", "late"});
+
+        // the raw snapshots only keep the last 10
+        const auto raw = history.series("iterations");
+        CHECK(raw.time.size() == 10);
+        CHECK(raw.time.front() == 90);
+        CHECK(raw.mean.back() == 99);
+
+        const auto buckets = history.series("iterations", 1);
+        REQUIRE(buckets.time.size() == 10);
+        CHECK(buckets.time.front() == 50);
+        CHECK(buckets.min.front() == 50);
+        CHECK(buckets.max.front() == 54);
+        CHECK(buckets.mean.front() == 52);
+
+        const auto coarse = history.series("late", 2);
+        REQUIRE(coarse.time.size() == 4);
+        CHECK(std::isnan(coarse.mean[0]));
+        CHECK(coarse.mean[2] == 2 * 62);
+
+        // the finest resolution that reaches back far enough
+        CHECK(history.query("iterations", 5).time.size() == 6);
+        CHECK(history.query("iterations", 30).time.size() == 7);
+        CHECK(history.query("iterations", 80).time.size() == 4);
+        CHECK(history.query("missing", 80).time.empty());
+
+        // coarse resolutions end with the bucket that is still filling up
+        for (int i = 100; i < 103; ++i)
+        {
+            stats.of("iterations") = i;
+            history.snapshot(stats, i);
+        }
+        const auto filling = history.series("iterations", 1);
+        REQUIRE(filling.time.size() == 11);
+        CHECK(filling.time.back() == 100);
+        CHECK(filling.min.back() == 100);
+        CHECK(filling.max.back() == 102);
+        CHECK(filling.mean.back() == 101);
+        CHECK(history.query("iterations", 2).time.size() == 3);
+        CHECK(history.query("iterations", 80).time.size() == 5);
+        CHECK(history.query("iterations", 80).mean.back() == 101);
+    }
+
+#ifdef SXS_STATS_BUILD_WITH_SHARDS
+    SUBCASE("every thread updates its own shard")
+    {
+        constexpr int num_threads = 4;
+        constexpr int num_loops = 100000;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+            threads.emplace_back(
+                [&stats]()
+                {
+                    auto &count = stats.of<long>("increments");
+                    for (int j = 0; j < num_loops; ++j)
+                        ++count;
+                    stats.of("iterations") += 1;
+                }
+            );
+        for (auto &&thread : threads)
+            thread.join();
+        CHECK(std::get<long>(stats.merged().at("increments")) == num_threads * num_loops);
+        CHECK(std::string(stats) == "{iterations: 9, failures: 1, increments: 400000}");
+    }
+#endif
+    stats.reset();
+}
+
+}  // namespace __sxs_stats
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,229 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "perf_counters.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace sxs
+{
+
+/*
+ * Heap allocations made by a thread, as counted by the global operator new/delete hook.
+ *
+ * The hook is opt-in: define SXS_INSTALL_ALLOC_HOOK in exactly one translation unit before
+ * including this file (the replacement operators cannot be inline). Over-aligned and
+ * non-operator-new allocations (e.g. malloc) are not counted.
+ */
+struct AllocCounts
+{
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t deallocations = 0;
+};
+
+// set by the hook on its first use
+inline std::atomic<bool> alloc_hook_installed{false};
+
+/*
+ * The running counts of the calling thread. Constant-initialised, so that it is safe to use from
+ * within operator new, even while the thread starts or exits.
+ */
+inline AllocCounts &thread_alloc_counts()
+{
+    thread_local AllocCounts counts;
+    return counts;
+}
+
+/*
+ * Sums of allocation deltas over a number of intervals.
+ */
+struct AllocTotals
+{
+    AllocCounts sums;
+    size_t count = 0;
+
+    inline void add(const AllocCounts &from, const AllocCounts &to)
+    {
+        sums.allocations += to.allocations - from.allocations;
+        sums.bytes += to.bytes - from.bytes;
+        sums.deallocations += to.deallocations - from.deallocations;
+        ++count;
+    }
+
+    inline void merge(const AllocTotals &other)
+    {
+        sums.allocations += other.sums.allocations;
+        sums.bytes += other.sums.bytes;
+        sums.deallocations += other.sums.deallocations;
+        count += other.count;
+    }
+
+    /*
+     * Format the mean per interval, e.g. " {allocs 2|bytes 1.02k|frees 2}".
+     */
+    std::string format() const
+    {
+        if (count == 0)
+            return "";
+        std::stringstream ss;
+        const auto mean = [this](uint64_t sum)
+        { return PerfCounterSet::format_count(static_cast<double>(sum) / count); };
+        ss << " {allocs " << mean(sums.allocations) << "|bytes " << mean(sums.bytes) << "|frees "
+           << mean(sums.deallocations) << "}";
+        return ss.str();
+    }
+};
+
+namespace detail
+{
+inline void *counted_allocate(std::size_t size)
+{
+    AllocCounts &counts = thread_alloc_counts();
+    ++counts.allocations;
+    counts.bytes += size;
+    if (!alloc_hook_installed.load(std::memory_order_relaxed))
+        alloc_hook_installed.store(true, std::memory_order_relaxed);
+
+    while (true)
+    {
+        if (void *ptr = std::malloc(size == 0 ? 1 : size))
+            return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            return nullptr;
+        handler();
+    }
+}
+
+inline void counted_deallocate(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    ++thread_alloc_counts().deallocations;
+    std::free(ptr);
+}
+}  // namespace detail
+
+}  // namespace sxs
+
+#ifdef SXS_INSTALL_ALLOC_HOOK
+void *operator new(std::size_t size)
+{
+    if (void *ptr = sxs::detail::counted_allocate(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return sxs::detail::counted_allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return sxs::detail::counted_allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    sxs::detail::counted_deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    sxs::detail::counted_deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    sxs::detail::counted_deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    sxs::detail::counted_deallocate(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    sxs::detail::counted_deallocate(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    sxs::detail::counted_deallocate(ptr);
+}
+#endif  // SXS_INSTALL_ALLOC_HOOK
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <memory>
+#include <vector>
+
+namespace __sxs_alloc_counter
+{
+
+TEST_CASE("[sxs] Allocation counter")
+{
+    if (!sxs::alloc_hook_installed)
+        return;
+
+    const sxs::AllocCounts before = sxs::thread_alloc_counts();
+    {
+        auto value = std::make_unique<int>(1);
+        std::vector<char> buffer(1000);
+    }
+    sxs::AllocTotals totals;
+    totals.add(before, sxs::thread_alloc_counts());
+    CHECK(totals.sums.allocations == 2);
+    CHECK(totals.sums.deallocations == 2);
+    CHECK(totals.sums.bytes >= 1000 + sizeof(int));
+    CHECK(totals.format() == " {allocs 2|bytes " +
+                                 sxs::PerfCounterSet::format_count(totals.sums.bytes) +
+                                 "|frees 2}");
+}
+
+}  // namespace __sxs_alloc_counter
+#endif  // SXS_RUN_TESTS
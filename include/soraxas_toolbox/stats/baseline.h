@@ -0,0 +1,329 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "timer.h"
+
+#include "../print_utils_core.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * Quantile of the standard normal distribution (Acklam's rational approximation, with a relative
+ * error below 1.2e-9).
+ */
+inline double normal_quantile(double p)
+{
+    static constexpr double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                                   -2.759285104469687e+02, 1.383577518672690e+02,
+                                   -3.066479806614716e+01, 2.506628277459239e+00};
+    static constexpr double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                                   -1.556989798598866e+02, 6.680131188771972e+01,
+                                   -1.328068155288572e+01};
+    static constexpr double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                                   -2.400758277161838e+00, -2.549732539343734e+00,
+                                   4.374664141464968e+00,  2.938163982698783e+00};
+    static constexpr double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                                   2.445134137142996e+00, 3.754408661907416e+00};
+    if (p <= 0 || p >= 1)
+        return p <= 0 ? -std::numeric_limits<double>::infinity()
+                      : std::numeric_limits<double>::infinity();
+    if (p < 0.02425 || p > 1 - 0.02425)
+    {
+        const double q = std::sqrt(-2 * std::log(p < 0.5 ? p : 1 - p));
+        const double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                         ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+        return p < 0.5 ? x : -x;
+    }
+    const double q = p - 0.5;
+    const double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+/*
+ * Quantile of Student's t distribution with (possibly fractional) degrees of freedom, exact for
+ * df < 3 (as df = 1 or 2) and a Cornish-Fisher expansion otherwise (Abramowitz & Stegun 26.7.5).
+ */
+inline double student_t_quantile(double p, double df)
+{
+    if (df < 1.5)
+        return std::tan(std::acos(-1.0) * (p - 0.5));
+    if (df < 3)
+        return (2 * p - 1) / std::sqrt(2 * p * (1 - p));
+    const double z = normal_quantile(p);
+    const double z2 = z * z;
+    const double g1 = (z2 + 1) * z / 4;
+    const double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+    const double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+    const double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+    return z + (g1 + (g2 + (g3 + g4 / df) / df) / df) / df;
+}
+
+/*
+ * The change of a mean from a baseline, as a fraction of the baseline mean (e.g. +0.1 is 10%
+ * slower), with its confidence interval from Welch's t-test.
+ */
+struct StatsComparison
+{
+    double baseline_mean;
+    double current_mean;
+    double change;
+    // NaN if either side has less than two samples, i.e. no variance
+    double change_low;
+    double change_high;
+    // the whole interval is beyond the threshold (or, without an interval, the change is)
+    bool regression;
+    bool improvement;
+
+    double speedup() const
+    {
+        return baseline_mean / current_mean;
+    }
+};
+
+/*
+ * Compare the mean of `current` to that of `baseline`. It is a regression (or an improvement) only
+ * if it is slower (or faster) by more than `threshold` with the given confidence.
+ */
+inline StatsComparison compare_stats(
+    const Stats<double> &baseline, const Stats<double> &current, double threshold = 0.05,
+    double confidence = 0.95
+)
+{
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    StatsComparison result{baseline.mean(), current.mean(), nan, nan, nan, false, false};
+    if (baseline.count == 0 || current.count == 0 || !(baseline.mean() > 0))
+        return result;
+
+    const double diff = current.mean() - baseline.mean();
+    result.change = diff / baseline.mean();
+    if (baseline.count < 2 || current.count < 2)
+    {
+        result.regression = result.change > threshold;
+        result.improvement = result.change < -threshold;
+        return result;
+    }
+
+    const double baseline_var = baseline.variance() / baseline.count;
+    const double current_var = current.variance() / current.count;
+    const double se = std::sqrt(baseline_var + current_var);
+    double margin = 0;
+    if (se > 0)
+    {
+        // Welch-Satterthwaite degrees of freedom
+        const double df =
+            (se * se * se * se) / (baseline_var * baseline_var / (baseline.count - 1) +
+                                   current_var * current_var / (current.count - 1));
+        margin = student_t_quantile((1 + confidence) / 2, df) * se;
+    }
+    result.change_low = (diff - margin) / baseline.mean();
+    result.change_high = (diff + margin) / baseline.mean();
+    result.regression = result.change_low > threshold;
+    result.improvement = result.change_high < -threshold;
+    return result;
+}
+
+template <typename Token>
+struct BaselineComparison
+{
+    TimeStampCollectionKey<Token> key;
+    StatsComparison comparison;
+    // the token pair only exists on one side
+    bool only_in_baseline = false;
+    bool only_in_current = false;
+};
+
+template <typename Token>
+std::vector<BaselineComparison<Token>> compare_to_baseline(
+    const TimeStampCollection<Token> &baseline, const TimeStampCollection<Token> &current,
+    double threshold = 0.05, double confidence = 0.95
+)
+{
+    std::vector<BaselineComparison<Token>> result;
+    for (auto &&item : current)
+    {
+        auto base = baseline.find(item.first);
+        if (base == baseline.end())
+        {
+            result.push_back({item.first, compare_stats({}, item.second), false, true});
+            continue;
+        }
+        result.push_back(
+            {item.first, compare_stats(base->second, item.second, threshold, confidence)}
+        );
+    }
+    for (auto &&item : baseline)
+    {
+        if (current.find(item.first) == current.end())
+            result.push_back({item.first, compare_stats(item.second, {}), true, false});
+    }
+    return result;
+}
+
+/*
+ * Print the change of every token pair from a baseline (e.g. one loaded with load_baseline() in
+ * soraxas_toolbox/cereal/stats.h), and return the number of regressions, such that a CI job can
+ * fail with `return print_baseline_comparison(...)`.
+ */
+template <typename Token>
+int print_baseline_comparison(
+    const TimeStampCollection<Token> &baseline, const TimeStampCollection<Token> &current,
+    double threshold = 0.05, double confidence = 0.95
+)
+{
+    using sxs::format_time2readable;
+    const auto comparisons = compare_to_baseline(baseline, current, threshold, confidence);
+
+    size_t name_max_len = 0;
+    std::vector<std::string> names;
+    for (auto &&item : comparisons)
+    {
+        names.push_back(
+            std::string(sxs::stats::get_token_name(item.key.first)) + " -> " +
+            std::string(sxs::stats::get_token_name(item.key.second))
+        );
+        name_max_len = std::max(name_max_len, names.back().size());
+    }
+
+    const auto percent = [](double fraction)
+    {
+        std::stringstream ss;
+        ss << std::showpos << std::fixed << std::setprecision(1) << fraction * 100 << "%";
+        return ss.str();
+    };
+
+    int num_regressions = 0;
+    sxs::println("========== baseline comparison ==========");
+    for (size_t i = 0; i < comparisons.size(); ++i)
+    {
+        const auto &item = comparisons[i];
+        const auto &comparison = item.comparison;
+        auto &stream = *sxs::get_print_output_stream();
+        stream << std::left << std::setw(name_max_len) << names[i] << ": ";
+        if (item.only_in_baseline || item.only_in_current)
+        {
+            stream << (item.only_in_current ? "new " : "removed ")
+                   << format_time2readable(
+                          item.only_in_current ? comparison.current_mean : comparison.baseline_mean
+                      )
+                   << std::endl;
+            continue;
+        }
+        stream << format_time2readable(comparison.baseline_mean) << " -> "
+               << format_time2readable(comparison.current_mean) << " "
+               << percent(comparison.change);
+        if (!std::isnan(comparison.change_low))
+            stream << " [" << percent(comparison.change_low) << ", "
+                   << percent(comparison.change_high) << "]";
+        if (comparison.regression)
+        {
+            ++num_regressions;
+            stream << " REGRESSION";
+        }
+        else if (comparison.improvement)
+            stream << " improvement";
+        stream << std::endl;
+    }
+    sxs::println(
+        "[", num_regressions, " regression(s) beyond ", threshold * 100, "% at ",
+        confidence * 100, "% confidence]"
+    );
+    sxs::println("=========================================");
+    return num_regressions;
+}
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/string.h"
+
+namespace __sxs_baseline
+{
+
+TEST_CASE("[sxs] Compare stamped stats to a baseline")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    CHECK(sxs::normal_quantile(0.975) == doctest::Approx(1.959964));
+    CHECK(sxs::student_t_quantile(0.975, 1) == doctest::Approx(12.7062));
+    CHECK(sxs::student_t_quantile(0.975, 10) == doctest::Approx(2.2281).epsilon(1e-3));
+    CHECK(sxs::student_t_quantile(0.975, 1e6) == doctest::Approx(1.959964));
+
+    auto stats_of = [](double mean, double spread)
+    {
+        sxs::Stats<double> stats;
+        for (int i = 0; i < 50; ++i)
+            stats.add(mean + spread * ((i % 5) - 2));
+        return stats;
+    };
+
+    sxs::TimeStampCollection<int> baseline, current;
+    baseline[{0, 1}] = stats_of(1e-3, 1e-5);
+    current[{0, 1}] = stats_of(1.2e-3, 1e-5);  // clearly slower
+    baseline[{1, 2}] = stats_of(1e-3, 4e-4);
+    current[{1, 2}] = stats_of(1.06e-3, 4e-4);  // within noise
+    baseline[{2, 3}] = stats_of(1e-3, 1e-5);
+    current[{2, 3}] = stats_of(0.5e-3, 1e-5);  // clearly faster
+    current[{3, 4}] = stats_of(1e-3, 0);
+
+    const auto slower = sxs::compare_stats(baseline[{0, 1}], current[{0, 1}]);
+    CHECK(slower.change == doctest::Approx(0.2));
+    CHECK(slower.change_low < 0.2);
+    CHECK(slower.change_high > 0.2);
+    CHECK(slower.regression);
+    CHECK(!sxs::compare_stats(baseline[{1, 2}], current[{1, 2}]).regression);
+    CHECK(sxs::compare_stats(baseline[{2, 3}], current[{2, 3}]).improvement);
+    CHECK(sxs::compare_stats(baseline[{2, 3}], current[{2, 3}]).speedup() == doctest::Approx(2));
+
+    CHECK(sxs::print_baseline_comparison(baseline, current) == 1);
+    const std::string output = guard.oss().str();
+    CHECK(sxs::string::contains(output, "+20.0% ["));
+    CHECK(sxs::string::contains(output, "REGRESSION"));
+    CHECK(sxs::string::contains(output, "improvement"));
+    CHECK(sxs::string::contains(output, "3 -> 4: new"));
+    // a looser threshold lets it pass
+    CHECK(sxs::print_baseline_comparison(baseline, current, 0.5) == 0);
+}
+
+}  // namespace __sxs_baseline
+#endif  // SXS_RUN_TESTS
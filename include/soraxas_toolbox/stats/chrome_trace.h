@@ -0,0 +1,353 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "profile_zone.h"
+#include "timer.h"
+
+#include "../clock.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace sxs
+{
+
+/*
+ * Timestamps of a trace are relative to this time point, which is taken during static
+ * initialisation (i.e. about when the program starts), such that all stampers and threads that
+ * use the same clock share a timeline.
+ */
+template <typename ClockPolicy>
+inline const typename ClockPolicy::time_point trace_origin = ClockPolicy::now();
+
+/*
+ * Streams events in the Chrome Trace Event JSON format, which can be opened with Perfetto
+ * (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Events are formatted straight into a fixed-size buffer that is flushed to the output stream
+ * whenever it is full, so no document is ever held in memory and the trace can have as many
+ * events as the disk allows. The JSON is closed by close(), or when the writer is destroyed.
+ */
+class ChromeTraceWriter
+{
+public:
+    explicit ChromeTraceWriter(std::ostream &stream, size_t buffer_size = 1 << 20)
+      : stream_(&stream), buffer_size_(buffer_size)
+    {
+        begin();
+    }
+
+    explicit ChromeTraceWriter(const std::string &filename, size_t buffer_size = 1 << 20)
+      : file_(std::make_unique<std::ofstream>(filename, std::ios::binary))
+      , stream_(file_.get())
+      , buffer_size_(buffer_size)
+    {
+        if (!*file_)
+            throw std::runtime_error("Unable to open trace file " + filename);
+        begin();
+    }
+
+    ~ChromeTraceWriter()
+    {
+        close();
+    }
+
+    ChromeTraceWriter(const ChromeTraceWriter &) = delete;
+    ChromeTraceWriter &operator=(const ChromeTraceWriter &) = delete;
+
+    /*
+     * A complete event, i.e., a slice with a start and a duration in microseconds.
+     */
+    void complete_event(
+        const std::string &name, const std::string &category, uint32_t tid, double start_us,
+        double duration_us
+    )
+    {
+        char numbers[96];
+        std::snprintf(
+            numbers, sizeof(numbers),
+            "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}", start_us,
+            duration_us, tid
+        );
+        begin_event();
+        append("{\"name\":\"");
+        append_escaped(name);
+        append("\",\"cat\":\"");
+        append_escaped(category);
+        append(numbers);
+        ++num_events_;
+    }
+
+    /*
+     * The trace id of a thread, which is registered (with a name) on first use.
+     */
+    uint32_t thread_index(std::thread::id thread, const std::string &name = "")
+    {
+        auto it = thread_indices_.find(thread);
+        if (it != thread_indices_.end())
+            return it->second;
+
+        const auto tid = static_cast<uint32_t>(thread_indices_.size() + 1);
+        thread_indices_.emplace(thread, tid);
+        char tid_str[16];
+        std::snprintf(tid_str, sizeof(tid_str), "%u", tid);
+        begin_event();
+        append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        append(tid_str);
+        append(",\"args\":{\"name\":\"");
+        append_escaped(name.empty() ? std::string("thread ") + tid_str : name);
+        append("\"}}");
+        return tid;
+    }
+
+    /*
+     * Write every interval of a TimeStamper (or TimeStamperDynamic) as an event named
+     * `token_from -> token_to`, on the timeline of the given thread.
+     */
+    template <typename Stamper, typename ClockPolicy = typename Stamper::clock_policy_t>
+    void write(
+        const Stamper &stamper, const std::string &category = "sxs",
+        std::thread::id thread = std::this_thread::get_id()
+    )
+    {
+        using Token = typename std::tuple_element<0, typename Stamper::stat_t>::type;
+
+        const uint32_t tid = thread_index(thread);
+        const auto origin = trace_origin<ClockPolicy>;
+        std::unordered_map<std::pair<Token, Token>, std::string, pair_hash> names;
+
+        stamper.for_each_interval(
+            [&](const Token &token_from, const Token &token_to,
+                const typename ClockPolicy::time_point &start,
+                const typename ClockPolicy::duration &duration)
+            {
+                auto key = std::make_pair(token_from, token_to);
+                auto name = names.find(key);
+                if (name == names.end())
+                {
+                    name = names
+                               .emplace(
+                                   key, std::string(sxs::stats::get_token_name(token_from)) +
+                                            " -> " +
+                                            std::string(sxs::stats::get_token_name(token_to))
+                               )
+                               .first;
+                }
+                complete_event(
+                    name->second, category, tid, ClockPolicy::to_secs(start - origin) * 1e6,
+                    ClockPolicy::to_secs(duration) * 1e6
+                );
+            }
+        );
+    }
+
+    /*
+     * Write the recorded events of a profile tree (see ProfileTree::set_record_events).
+     */
+    void write(
+        const ProfileTree &tree, const std::string &category = "zone",
+        std::thread::id thread = std::this_thread::get_id()
+    )
+    {
+        using clock_ = ProfileTree::clock_;
+
+        const uint32_t tid = thread_index(thread);
+        const auto origin = trace_origin<clock_>;
+        for (auto &&event : tree.events())
+        {
+            complete_event(
+                tree.nodes()[event.node].name, category, tid,
+                clock_::to_secs(event.start - origin) * 1e6, clock_::to_secs(event.duration) * 1e6
+            );
+        }
+    }
+
+    /*
+     * Write the recorded zone events of every thread.
+     */
+    void write_profile_zones(const std::string &category = "zone")
+    {
+        std::lock_guard<std::mutex> guard(get_profile_trees_lock());
+        for (auto &&tree : get_profile_trees())
+            write(*tree.second, category, tree.first);
+    }
+
+    size_t num_events() const
+    {
+        return num_events_;
+    }
+
+    void flush()
+    {
+        stream_->write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+        stream_->flush();
+    }
+
+    void close()
+    {
+        if (closed_)
+            return;
+        closed_ = true;
+        append("\n]}\n");
+        flush();
+    }
+
+protected:
+    void begin()
+    {
+        buffer_.reserve(buffer_size_);
+        append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    }
+
+    inline void begin_event()
+    {
+        append(is_first_event_ ? "\n" : ",\n");
+        is_first_event_ = false;
+    }
+
+    inline void append(const char *str)
+    {
+        append(str, std::char_traits<char>::length(str));
+    }
+
+    inline void append(const char *str, size_t length)
+    {
+        if (buffer_.size() + length > buffer_size_)
+        {
+            stream_->write(buffer_.data(), buffer_.size());
+            buffer_.clear();
+        }
+        buffer_.append(str, length);
+    }
+
+    void append_escaped(const std::string &str)
+    {
+        size_t plain_start = 0;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            const auto c = static_cast<unsigned char>(str[i]);
+            if (c != '"' && c != '\\' && c >= 0x20)
+                continue;
+            append(str.data() + plain_start, i - plain_start);
+            plain_start = i + 1;
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            append(escaped);
+        }
+        append(str.data() + plain_start, str.size() - plain_start);
+    }
+
+    std::unique_ptr<std::ofstream> file_;
+    std::ostream *stream_;
+    std::string buffer_;
+    size_t buffer_size_;
+    size_t num_events_ = 0;
+    bool is_first_event_ = true;
+    bool closed_ = false;
+    std::unordered_map<std::thread::id, uint32_t> thread_indices_;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/string.h"
+
+#include <sstream>
+
+namespace __sxs_chrome_trace
+{
+
+TEST_CASE("[sxs] Chrome trace export")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+    std::stringstream output;
+
+    sxs::TimeStamperDynamic dynamic_timer;
+    dynamic_timer.set_autoprint(false);
+    dynamic_timer.stamp("hi");
+    dynamic_timer.stamp("\"bye\"");
+    dynamic_timer.stamp("hi");
+
+    sxs::TimeStamper<int> timer;
+    timer.set_autoprint(false);
+    timer.stamp<1>();
+    timer.stamp<2>();
+
+    sxs::ProfileTree tree;
+    std::thread(
+        [&tree]()
+        {
+            sxs::get_thread_profile_tree().set_record_events();
+            {
+                SXS_PROFILE_SCOPE("outer");
+                SXS_PROFILE_SCOPE("inner");
+            }
+            tree = sxs::get_thread_profile_tree();
+            sxs::get_thread_profile_tree().set_record_events(false);
+        }
+    ).join();
+    CHECK(tree.events().size() == 2);
+
+    {
+        // a tiny buffer to exercise flushing mid-event
+        sxs::ChromeTraceWriter writer(output, 16);
+        writer.write(dynamic_timer);
+        writer.write(timer, "int stamper");
+        writer.write(tree, "zone", std::thread::id());
+        CHECK(writer.num_events() == 5);
+    }
+
+    const std::string json = output.str();
+    CHECK(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+    CHECK(sxs::string::contains(json, "\n]}\n"));
+    CHECK(!sxs::string::contains(json, ",\n]"));
+    CHECK(sxs::string::contains(json, "\"name\":\"hi -> \\u0022bye\\u0022\""));
+    CHECK(sxs::string::contains(json, "\"name\":\"1 -> 2\",\"cat\":\"int stamper\""));
+    CHECK(sxs::string::contains(json, "\"name\":\"inner\",\"cat\":\"zone\""));
+    // the zones were written as a second thread
+    CHECK(sxs::string::contains(json, "\"tid\":2"));
+    CHECK(sxs::string::contains(json, "\"args\":{\"name\":\"thread 1\"}"));
+}
+
+}  // namespace __sxs_chrome_trace
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,454 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "timer.h"
+
+#include "../main.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace sxs
+{
+
+/*
+ * A TimeStamper that can be stamped from multiple threads at once.
+ *
+ * Each thread appends into its own buffer (padded to a cache line, so threads never share one),
+ * hence stamping takes no lock after the first stamp of a thread. All buffers are merged when
+ * the result is compiled, which must happen after the stamping threads are done (e.g. joined).
+ * As with TimeStamper, the clock is chosen by a ClockPolicy (see clock.h).
+ */
+template <typename Token, typename ClockPolicy = clock_policy::default_clock>
+class ConcurrentTimeStamper : public TimerBase<ClockPolicy>
+{
+protected:
+    using clock_ = ClockPolicy;
+    using TimerBase<ClockPolicy>::timepoint_diff_to_secs;
+
+public:
+    using stat_t = TimeStamperStatIteratorReturnType<Token>;
+    using clock_policy_t = ClockPolicy;
+
+    struct alignas(cache_line_size) ThreadBuffer
+    {
+        using stat_t = TimeStamperStatIteratorReturnType<Token>;
+
+        std::vector<stat_t> stamped;
+        Token last_stamped_token{};
+        typename clock_::time_point last_stamped_clock;
+        bool is_first = true;
+        // identifies the thread, as its std::thread::id may be reused once it exits
+        std::uint64_t thread_serial = 0;
+        // only a label of the thread
+        std::thread::id thread_id;
+
+        typename std::vector<stat_t>::const_iterator begin() const
+        {
+            return stamped.begin();
+        }
+
+        typename std::vector<stat_t>::const_iterator end() const
+        {
+            return stamped.end();
+        }
+
+        bool check_validity() const
+        {
+            return true;
+        }
+    };
+
+    ConcurrentTimeStamper(const std::string &name = "", bool auto_print = true)
+      : name(name), m_autoprint(auto_print), m_finished(false), m_id(next_instance_id())
+    {
+    }
+
+    ~ConcurrentTimeStamper()
+    {
+        finish();
+    }
+
+    void stamp(const Token &token)
+    {
+        ThreadBuffer &buffer = get_thread_buffer();
+        const auto now = clock_::now();
+        if (!buffer.is_first)
+        {
+            buffer.stamped.emplace_back(
+                buffer.last_stamped_token, token,
+                timepoint_diff_to_secs(now - buffer.last_stamped_clock)
+            );
+        }
+        buffer.is_first = false;
+        buffer.last_stamped_token = token;
+        buffer.last_stamped_clock = clock_::now();
+    }
+
+    template <auto t>
+    void stamp()
+    {
+        static_assert(std::is_same<std::decay_t<decltype(t)>, Token>::value, "Token type mismatch");
+        stamp(t);
+    }
+
+    size_t count() const
+    {
+        size_t total = 0;
+        for (auto &&buffer : m_buffers)
+            total += buffer->stamped.size();
+        return total;
+    }
+
+    size_t num_threads() const
+    {
+        return m_buffers.size();
+    }
+
+    /*
+     * Clear all per-thread buffers. Must not be called while other threads are stamping.
+     */
+    void reset() override
+    {
+        TimerBase<ClockPolicy>::reset();
+        for (auto &&buffer : m_buffers)
+        {
+            buffer->stamped.clear();
+            buffer->is_first = true;
+        }
+    }
+
+    void finish()
+    {
+        if (m_finished)
+            return;
+        m_finished = true;
+        if (m_autoprint)
+        {
+            if (count() > 0)
+                print_stamped_stats();
+            else
+                *sxs::get_print_output_stream() << operator std::string() << std::endl;
+        }
+    }
+
+    /*
+     * Compile the stamped result of each thread separately, in the order that threads first
+     * stamped.
+     */
+    std::vector<std::pair<std::thread::id, TimeStampCollection<Token>>>
+    compile_result_per_thread() const
+    {
+        std::vector<std::pair<std::thread::id, TimeStampCollection<Token>>> results;
+        results.reserve(m_buffers.size());
+        for (auto &&buffer : m_buffers)
+            results.emplace_back(buffer->thread_id, sxs::compile_result(*buffer));
+        return results;
+    }
+
+    void print_stamped_stats(bool per_thread = false) const
+    {
+        if (per_thread)
+        {
+            for (auto &&thread_result : compile_result_per_thread())
+            {
+                sxs::println("[", name, "] thread ", thread_result.first);
+                print_compiled_stats(thread_result.second);
+            }
+        }
+        sxs::println("[", name, "] combined ", num_threads(), " threads");
+        print_compiled_stats(compile_result(*this));
+    }
+
+    operator std::string() const
+    {
+        std::stringstream ss;
+        ss << "[" << name << "] elapsed: " << sxs::format_time2readable(this->elapsed()) << " [stamped "
+           << count() << " from " << num_threads() << " threads]";
+        return ss.str();
+    }
+
+    friend std::ostream &operator<<(std::ostream &_stream, const ConcurrentTimeStamper &t)
+    {
+        return _stream << std::string(t);
+    }
+
+    void set_autoprint(bool autoprint = true)
+    {
+        m_autoprint = autoprint;
+    }
+
+    /*
+     * Iterate through the stamped data of all threads, one thread after another.
+     */
+    class iterator
+    {
+        const std::vector<std::unique_ptr<ThreadBuffer>> &buffers_ref_;
+        size_t buffer_num;
+        size_t num;
+
+        void skip_exhausted_buffers()
+        {
+            while (buffer_num < buffers_ref_.size() &&
+                   num >= buffers_ref_[buffer_num]->stamped.size())
+            {
+                ++buffer_num;
+                num = 0;
+            }
+        }
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = stat_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const stat_t *;
+        using reference = const stat_t &;
+
+        explicit iterator(const std::vector<std::unique_ptr<ThreadBuffer>> &ref, size_t _buffer_num)
+          : buffers_ref_(ref), buffer_num(_buffer_num), num(0)
+        {
+            skip_exhausted_buffers();
+        }
+
+        iterator &operator++()
+        {
+            ++num;
+            skip_exhausted_buffers();
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator retval = *this;
+            ++(*this);
+            return retval;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            return buffer_num == other.buffer_num && num == other.num;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+        reference operator*() const
+        {
+            return buffers_ref_[buffer_num]->stamped[num];
+        }
+    };
+
+    iterator begin() const
+    {
+        return iterator(m_buffers, 0);
+    }
+
+    iterator end() const
+    {
+        return iterator(m_buffers, m_buffers.size());
+    }
+
+    bool check_validity() const
+    {
+        return true;
+    }
+
+protected:
+    static std::uint64_t next_instance_id()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    // a serial number per thread, which (unlike std::thread::id) is never reused by a later thread
+    static std::uint64_t thread_serial()
+    {
+        static std::atomic<std::uint64_t> num_threads{0};
+        thread_local const std::uint64_t serial = ++num_threads;
+        return serial;
+    }
+
+    // the stampers a thread has recently used, such that alternating between a few never locks
+    struct ThreadCache
+    {
+        static constexpr size_t num_slots = 8;
+        std::array<std::pair<std::uint64_t, ThreadBuffer *>, num_slots> slots{};
+        size_t next_slot = 0;
+    };
+
+    ThreadBuffer &get_thread_buffer()
+    {
+        // fast path: a stamper recently used by this thread. Instance ids are never reused (and
+        // start at 1), hence a stale entry from a destroyed stamper can never match.
+        thread_local ThreadCache cache;
+        for (auto &&slot : cache.slots)
+        {
+            if (slot.first == m_id)
+                return *slot.second;
+        }
+
+        const auto serial = thread_serial();
+        std::lock_guard<std::mutex> guard(m_buffers_lock);
+        ThreadBuffer *buffer = nullptr;
+        for (auto &&existing : m_buffers)
+        {
+            if (existing->thread_serial == serial)
+            {
+                buffer = existing.get();
+                break;
+            }
+        }
+        if (!buffer)
+        {
+            m_buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = m_buffers.back().get();
+            buffer->thread_serial = serial;
+            buffer->thread_id = std::this_thread::get_id();
+        }
+        cache.slots[cache.next_slot] = {m_id, buffer};
+        cache.next_slot = (cache.next_slot + 1) % ThreadCache::num_slots;
+        return *buffer;
+    }
+
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::mutex m_buffers_lock;
+
+    std::string name;
+    bool m_autoprint;
+    bool m_finished;
+    const std::uint64_t m_id;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/string.h"
+
+namespace __sxs_concurrent_timer
+{
+
+TEST_CASE("[sxs] Stamp from multiple threads concurrently")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    const size_t num_threads = 4;
+    const size_t num_iterations = 100;
+
+    sxs::ConcurrentTimeStamper<std::string> timer("workers");
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_threads; ++i)
+    {
+        workers.emplace_back(
+            [&timer, num_iterations]()
+            {
+                for (size_t j = 0; j < num_iterations; ++j)
+                {
+                    timer.stamp("begin");
+                    timer.stamp("end");
+                }
+            }
+        );
+    }
+    for (auto &&worker : workers)
+        worker.join();
+
+    CHECK(timer.num_threads() == num_threads);
+    CHECK(timer.count() == num_threads * (2 * num_iterations - 1));
+
+    auto combined = sxs::compile_result(timer);
+    CHECK(combined[{"begin", "end"}].count == num_threads * num_iterations);
+    CHECK(combined[{"end", "begin"}].count == num_threads * (num_iterations - 1));
+
+    auto per_thread = timer.compile_result_per_thread();
+    REQUIRE(per_thread.size() == num_threads);
+    for (auto &&thread_result : per_thread)
+        CHECK(thread_result.second.at({"begin", "end"}).count == num_iterations);
+
+    timer.print_stamped_stats(true);
+    CHECK(sxs::string::contains(guard.oss().str(), "combined 4 threads"));
+}
+
+TEST_CASE("[sxs] Alternate between concurrent stampers")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::ConcurrentTimeStamper<int> first("first", false);
+    sxs::ConcurrentTimeStamper<int, sxs::clock_policy::steady> second("second", false);
+    for (int i = 0; i < 100; ++i)
+    {
+        first.stamp(i % 2);
+        second.stamp(i % 2);
+    }
+    CHECK(first.num_threads() == 1);
+    CHECK(second.num_threads() == 1);
+    CHECK(first.count() == 99);
+    CHECK(compile_result(second)[{0, 1}].count == 50);
+}
+
+TEST_CASE("[sxs] Concurrent stamper across short-lived threads")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    // a new thread may reuse the id of one that exited, but never its buffer
+    sxs::ConcurrentTimeStamper<int> timer("short-lived", false);
+    std::thread(
+        [&timer]()
+        {
+            timer.stamp(0);
+            timer.stamp(1);
+        }
+    ).join();
+    std::thread(
+        [&timer]()
+        {
+            timer.stamp(2);
+            timer.stamp(3);
+        }
+    ).join();
+    CHECK(timer.num_threads() == 2);
+    CHECK(timer.count() == 2);
+    auto stats = compile_result(timer);
+    CHECK(stats.find({1, 2}) == stats.end());
+    CHECK(stats[{2, 3}].count == 1);
+    CHECK(timer.compile_result_per_thread().size() == 2);
+}
+
+}  // namespace __sxs_concurrent_timer
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,268 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "timer.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace sxs
+{
+
+/*
+ * A host-side TimeStamper that never allocates after construction.
+ *
+ * Stamps are stored as raw (token, timepoint) pairs in a fixed ring buffer that overwrites the
+ * oldest stamp once full, so it can stay enabled inside a real-time loop. Durations are only
+ * computed when iterating (e.g. in compile_result), never while stamping.
+ */
+template <class Token, size_t BufferSize, typename ClockPolicy = clock_policy::default_clock>
+class TimeStamperFixed
+{
+    static_assert(BufferSize >= 2, "Must be at least of size 2 to form a pair of stamps");
+
+    using clock_ = ClockPolicy;
+
+public:
+    using token_t = Token;
+    using stat_t = TimeStamperStatIteratorReturnType<Token>;
+    // clang-format off
+        // conditionally use smaller size to store index_
+        using StorageIndexType =
+                std::conditional_t<
+                        BufferSize < (2 << (8 - 1)), uint8_t,
+                        std::conditional_t<
+                                BufferSize < (2 << (16 - 1)), uint16_t,
+                                std::conditional_t<
+                                        BufferSize < (2ull << (31 - 1)), uint32_t,
+                                        uint64_t
+                                >>>;
+
+    // clang-format on
+
+    struct StampedData
+    {
+        Token event;
+        typename clock_::time_point timepoint;
+    };
+
+    TimeStamperFixed() = default;
+
+    void reset()
+    {
+        head_ = 0;
+        size_ = 0;
+        num_stamped_ = 0;
+    }
+
+    template <Token e>
+    inline void stamp()
+    {
+        stamp(e);
+    }
+
+    inline void stamp(const Token e)
+    {
+        events_[head_].timepoint = clock_::now();
+        events_[head_].event = e;
+
+        head_ = (head_ + 1 == BufferSize) ? 0 : head_ + 1;
+        if (size_ < BufferSize)
+            ++size_;
+        ++num_stamped_;
+    }
+
+    /*
+     * Number of stamped intervals that are still stored.
+     */
+    size_t count() const
+    {
+        return size_ > 0 ? size_ - 1 : 0;
+    }
+
+    /*
+     * Number of stamps that had been overwritten as the buffer was full.
+     */
+    size_t num_dropped() const
+    {
+        return num_stamped_ - size_;
+    }
+
+    /*
+     * The i-th oldest stamp that is still stored.
+     */
+    const StampedData &at(size_t i) const
+    {
+        const size_t oldest = (size_ < BufferSize) ? 0 : head_;
+        const size_t pos = oldest + i;
+        return events_[pos < BufferSize ? pos : pos - BufferSize];
+    }
+
+    void print_stamped_stats() const
+    {
+        check_validity();
+        print_compiled_stats(compile_result(*this));
+    }
+
+    class iterator
+    {
+        const TimeStamperFixed &stamper_ref_;
+        size_t num;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = stat_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const stat_t *;
+        using reference = stat_t;
+
+        explicit iterator(const TimeStamperFixed &ref, size_t _num) : stamper_ref_(ref), num(_num)
+        {
+        }
+
+        iterator &operator++()
+        {
+            num++;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator retval = *this;
+            ++(*this);
+            return retval;
+        }
+
+        bool operator==(iterator other) const
+        {
+            return num == other.num;
+        }
+
+        bool operator!=(iterator other) const
+        {
+            return !(*this == other);
+        }
+
+        stat_t operator*() const
+        {
+            const StampedData &from = stamper_ref_.at(num);
+            const StampedData &to = stamper_ref_.at(num + 1);
+            return std::make_tuple<Token, Token, double>(
+                ((Token)from.event), ((Token)to.event),
+                clock_::to_secs(to.timepoint - from.timepoint)
+            );
+        }
+    };
+
+    iterator begin() const
+    {
+        return iterator(*this, 0);
+    }
+
+    iterator end() const
+    {
+        return iterator(*this, count());
+    }
+
+    bool check_validity() const
+    {
+        if (num_dropped() > 0)
+        {
+            sxs::println("================ WARNING ====================");
+            sxs::println(" Buffer is full capacity at ", size_, "/", BufferSize);
+            sxs::println(" The oldest ", num_dropped(), " stamps had been overwritten.");
+            sxs::println("=============================================");
+            return false;
+        }
+        return true;
+    }
+
+protected:
+    StampedData events_[BufferSize];
+    StorageIndexType head_ = 0;
+    StorageIndexType size_ = 0;
+    size_t num_stamped_ = 0;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+namespace __sxs_fixed_timer
+{
+
+TEST_CASE("[sxs] Fixed capacity time stamper")
+{
+    sxs::TimeStamperFixed<int, 4> timer;
+    CHECK(timer.count() == 0);
+    CHECK(timer.begin() == timer.end());
+
+    timer.stamp<1>();
+    timer.stamp<2>();
+    timer.stamp<1>();
+    CHECK(timer.count() == 2);
+    CHECK(timer.check_validity());
+
+    SUBCASE("overwrite the oldest stamps once full")
+    {
+        sxs::SXSPrintOutputStreamGuard guard;
+
+        timer.stamp<2>();
+        timer.stamp<1>();
+        timer.stamp<3>();
+        CHECK(timer.count() == 3);
+        CHECK(timer.num_dropped() == 2);
+        CHECK(!timer.check_validity());
+
+        // retained stamps are [1, 2, 1, 3]
+        auto result = sxs::compile_result(timer);
+        CHECK(result.size() == 3);
+        CHECK(result[{1, 2}].count == 1);
+        CHECK(result[{2, 1}].count == 1);
+        CHECK(result[{1, 3}].count == 1);
+        CHECK(result[{1, 3}].min >= 0);
+    }
+
+    SUBCASE("reset")
+    {
+        timer.reset();
+        CHECK(timer.count() == 0);
+        timer.stamp<3>();
+        timer.stamp<3>();
+        CHECK(sxs::compile_result(timer)[{3, 3}].count == 1);
+    }
+}
+
+}  // namespace __sxs_fixed_timer
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,215 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * A fixed-memory histogram with logarithmic buckets, in the style of HdrHistogram.
+ *
+ * Values are quantised to integer multiples of `unit`, then bucketed by their power of two, each
+ * power being split linearly into 2^(SubBucketBits - 1) sub-buckets. Hence recording is O(1)
+ * and any percentile is within a relative error of 2^-(SubBucketBits - 1) of the recorded value.
+ * Values above 2^MaxValueBits units are clamped into the last bucket.
+ */
+template <unsigned SubBucketBits = 7, unsigned MaxValueBits = 44>
+class LogHistogram
+{
+    static_assert(SubBucketBits >= 2 && SubBucketBits < MaxValueBits && MaxValueBits < 64, "");
+
+    static constexpr uint64_t sub_bucket_count = uint64_t(1) << SubBucketBits;
+    static constexpr uint64_t sub_bucket_half_count = sub_bucket_count / 2;
+    static constexpr uint64_t sub_bucket_mask = sub_bucket_count - 1;
+    static constexpr unsigned num_buckets = MaxValueBits - SubBucketBits + 1;
+    static constexpr uint64_t max_value = (uint64_t(1) << MaxValueBits) - 1;
+
+public:
+    static constexpr size_t num_counts = (num_buckets + 1) * sub_bucket_half_count;
+
+    /*
+     * The default unit is a nanosecond, for values recorded in seconds.
+     */
+    explicit LogHistogram(double unit = 1e-9) : counts_(num_counts, 0), unit_(unit)
+    {
+    }
+
+    inline void record(double value, uint64_t count = 1)
+    {
+        counts_[index_of(to_units(value))] += count;
+        total_count_ += count;
+    }
+
+    void merge(const LogHistogram &rhs)
+    {
+        assert(unit_ == rhs.unit_);
+        for (size_t i = 0; i < num_counts; ++i)
+            counts_[i] += rhs.counts_[i];
+        total_count_ += rhs.total_count_;
+    }
+
+    void reset()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_count_ = 0;
+    }
+
+    uint64_t total_count() const
+    {
+        return total_count_;
+    }
+
+    /*
+     * The highest value that is equivalent (i.e. shares a bucket) to the value at the given
+     * percentile (0 ~ 100).
+     */
+    double value_at_percentile(double percentile) const
+    {
+        if (total_count_ == 0)
+            return std::numeric_limits<double>::quiet_NaN();
+        const double fraction = std::min(std::max(percentile, 0.), 100.) / 100.;
+        const uint64_t target =
+            std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total_count_)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < num_counts; ++i)
+        {
+            seen += counts_[i];
+            if (seen >= target)
+                return highest_equivalent_value(i) * unit_;
+        }
+        return max_value * unit_;
+    }
+
+    // for cereal, see soraxas_toolbox/cereal/stats.h
+    template <class Archive>
+    void serialize(Archive &archive)
+    {
+        archive(counts_, total_count_, unit_);
+    }
+
+protected:
+    inline uint64_t to_units(double value) const
+    {
+        if (!(value > 0))
+            return 0;
+        const double units = value / unit_;
+        return units >= max_value ? max_value : static_cast<uint64_t>(units);
+    }
+
+    static inline unsigned floor_log2(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        unsigned result = 0;
+        while (value >>= 1)
+            ++result;
+        return result;
+#endif
+    }
+
+    static inline size_t index_of(uint64_t value)
+    {
+        const unsigned bucket = floor_log2(value | sub_bucket_mask) - (SubBucketBits - 1);
+        const uint64_t sub_bucket = value >> bucket;
+        return ((bucket + 1) << (SubBucketBits - 1)) + sub_bucket - sub_bucket_half_count;
+    }
+
+    static inline uint64_t highest_equivalent_value(size_t index)
+    {
+        if (index < sub_bucket_count)
+            return index;
+        const unsigned bucket = (index >> (SubBucketBits - 1)) - 1;
+        const uint64_t sub_bucket = (index & (sub_bucket_half_count - 1)) + sub_bucket_half_count;
+        return ((sub_bucket + 1) << bucket) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    double unit_;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+namespace __sxs_histogram
+{
+
+TEST_CASE("[sxs] Log histogram percentiles")
+{
+    sxs::LogHistogram<> histogram;
+    CHECK(std::isnan(histogram.value_at_percentile(50)));
+
+    // 1µs ~ 1000µs
+    for (int i = 1; i <= 1000; ++i)
+        histogram.record(i * 1e-6);
+    CHECK(histogram.total_count() == 1000);
+
+    auto approx = [](double value) { return doctest::Approx(value).epsilon(1. / 64); };
+    CHECK(histogram.value_at_percentile(50) == approx(500e-6));
+    CHECK(histogram.value_at_percentile(90) == approx(900e-6));
+    CHECK(histogram.value_at_percentile(99) == approx(990e-6));
+    CHECK(histogram.value_at_percentile(100) == approx(1000e-6));
+    CHECK(histogram.value_at_percentile(0) == approx(1e-6));
+
+    SUBCASE("merged histograms equal a single one")
+    {
+        sxs::LogHistogram<> first, second;
+        for (int i = 1; i <= 1000; ++i)
+            (i % 3 ? first : second).record(i * 1e-6);
+        first.merge(second);
+        CHECK(first.total_count() == 1000);
+        for (double p : {0., 25., 50., 99.9, 100.})
+            CHECK(first.value_at_percentile(p) == histogram.value_at_percentile(p));
+    }
+
+    SUBCASE("out of range values are clamped")
+    {
+        sxs::LogHistogram<> clamped;
+        clamped.record(-1);
+        clamped.record(1e9);
+        CHECK(clamped.value_at_percentile(0) == 0);
+        CHECK(clamped.value_at_percentile(100) > 1e4);
+    }
+}
+
+}  // namespace __sxs_histogram
+#endif  // SXS_RUN_TESTS
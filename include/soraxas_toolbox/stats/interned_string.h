@@ -0,0 +1,263 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+namespace sxs
+{
+
+/*
+ * A process-wide table that maps each distinct string to a small integer id, assigned in the order
+ * strings are first seen. Id 0 is always the empty string.
+ *
+ * Every thread caches the ids it has seen, so interning a seen string only hashes it once and
+ * never locks. A C string (e.g. a literal) is first looked up by its address, which skips even
+ * the hash.
+ */
+class StringInterner
+{
+public:
+    static StringInterner &instance()
+    {
+        static StringInterner interner;
+        return interner;
+    }
+
+    uint32_t intern(const std::string &str)
+    {
+        thread_local std::unordered_map<std::string, uint32_t> cache;
+        auto cached = cache.find(str);
+        if (cached != cache.end())
+            return cached->second;
+
+        uint32_t id;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            auto result = ids_.emplace(str, static_cast<uint32_t>(names_.size()));
+            if (result.second)
+                names_.push_back(str);
+            id = result.first->second;
+        }
+        cache.emplace(str, id);
+        return id;
+    }
+
+    uint32_t intern(const char *str)
+    {
+        // a direct-mapped cache keyed by address. The content is still compared, as the same
+        // buffer may hold another string by now.
+        struct Slot
+        {
+            const char *key = nullptr;
+            const std::string *name = nullptr;
+            uint32_t id = 0;
+        };
+        thread_local std::array<Slot, 64> slots;
+        Slot &slot = slots[(reinterpret_cast<uintptr_t>(str) >> 3) % slots.size()];
+        if (slot.key == str && std::strcmp(str, slot.name->c_str()) == 0)
+            return slot.id;
+
+        const uint32_t id = intern(std::string(str));
+        slot = Slot{str, &name(id), id};
+        return id;
+    }
+
+    /*
+     * The string of an interned id. References stay valid as the table only ever grows.
+     */
+    const std::string &name(uint32_t id) const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return names_[id];
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return names_.size();
+    }
+
+private:
+    StringInterner()
+    {
+        ids_.emplace("", 0);
+        names_.emplace_back();
+    }
+
+    mutable std::mutex lock_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::deque<std::string> names_;
+};
+
+/*
+ * A string token that is stored, compared and hashed as its interned id, and only resolved back
+ * to its string when printing.
+ *
+ * Interning costs a hash of the string; keep a (static) InternedString around to stamp a label
+ * repeatedly without even that.
+ */
+class InternedString
+{
+public:
+    InternedString() = default;
+
+    InternedString(const std::string &str) : id_(StringInterner::instance().intern(str))
+    {
+    }
+
+    InternedString(const char *str) : id_(StringInterner::instance().intern(str))
+    {
+    }
+
+    uint32_t id() const
+    {
+        return id_;
+    }
+
+    bool empty() const
+    {
+        return id_ == 0;
+    }
+
+    const std::string &str() const
+    {
+        return StringInterner::instance().name(id_);
+    }
+
+    bool operator==(const InternedString &other) const
+    {
+        return id_ == other.id_;
+    }
+
+    bool operator!=(const InternedString &other) const
+    {
+        return id_ != other.id_;
+    }
+
+    // orders by first appearance, not alphabetically
+    bool operator<(const InternedString &other) const
+    {
+        return id_ < other.id_;
+    }
+
+private:
+    uint32_t id_ = 0;
+};
+
+inline std::string to_string(const InternedString &token)
+{
+    return token.str();
+}
+
+inline std::ostream &operator<<(std::ostream &stream, const InternedString &token)
+{
+    return stream << token.str();
+}
+
+}  // namespace sxs
+
+namespace std
+{
+template <>
+struct hash<sxs::InternedString>
+{
+    std::size_t operator()(const sxs::InternedString &token) const
+    {
+        return std::hash<uint32_t>()(token.id());
+    }
+};
+}  // namespace std
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <thread>
+#include <vector>
+
+namespace __sxs_interned_string
+{
+
+TEST_CASE("[sxs] Interned strings")
+{
+    const sxs::InternedString hello{"interned hello"};
+    const sxs::InternedString world{std::string("interned world")};
+
+    CHECK(sxs::InternedString().empty());
+    CHECK(sxs::InternedString("").empty());
+    CHECK(!hello.empty());
+    CHECK(hello != world);
+    CHECK(hello == sxs::InternedString("interned hello"));
+    CHECK(hello.str() == "interned hello");
+    CHECK(sxs::to_string(world) == "interned world");
+
+    SUBCASE("ids agree across threads")
+    {
+        std::vector<uint32_t> ids(4);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < ids.size(); ++i)
+            threads.emplace_back(
+                [&ids, i]()
+                {
+                    for (int j = 0; j < 100; ++j)
+                        sxs::InternedString(std::to_string(j) + " interned");
+                    ids[i] = sxs::InternedString("interned world").id();
+                }
+            );
+        for (auto &&thread : threads)
+            thread.join();
+        for (auto &&id : ids)
+            CHECK(id == world.id());
+        CHECK(sxs::InternedString("99 interned").str() == "99 interned");
+    }
+
+    SUBCASE("a reused buffer is not mistaken for its previous string")
+    {
+        char buffer[32];
+        std::strcpy(buffer, "interned hello");
+        CHECK(sxs::InternedString(buffer) == hello);
+        CHECK(sxs::InternedString(buffer) == hello);
+        std::strcpy(buffer, "interned world");
+        CHECK(sxs::InternedString(buffer) == world);
+    }
+}
+
+}  // namespace __sxs_interned_string
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,397 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * A lock that spins on an atomic flag, for critical sections that are only a few instructions.
+ */
+class SpinLock
+{
+public:
+    inline void lock()
+    {
+        while (flag_.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    inline void unlock()
+    {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+/*
+ * A TimeStamper (or TimeStamperDynamic) whose recorded intervals can be taken out from another
+ * thread while it keeps stamping, e.g., by a LiveReporter.
+ *
+ * Each stamp takes an uncontended spin lock, which is only ever held by the other side for the
+ * swap of two vectors: the buffers of the previous snapshot are emptied (and the overhead to
+ * subtract is calibrated) before locking, and take the place of the recorded ones.
+ */
+template <typename Stamper>
+class LiveStamper : public Stamper
+{
+public:
+    using Stamper::Stamper;
+
+    template <auto token>
+    inline void stamp()
+    {
+        std::lock_guard<SpinLock> guard(lock_);
+        Stamper::template stamp<token>();
+    }
+
+    template <typename... Args>
+    inline void stamp(Args &&...args)
+    {
+        std::lock_guard<SpinLock> guard(lock_);
+        Stamper::stamp(std::forward<Args>(args)...);
+    }
+
+    auto snapshot_and_reset()
+    {
+        std::lock_guard<std::mutex> snapshot_guard(snapshot_lock_);
+        Stamper::prepare_snapshot(snapshot_);
+        {
+            std::lock_guard<SpinLock> guard(lock_);
+            Stamper::take_snapshot(snapshot_);
+        }
+        return compile_result(snapshot_);
+    }
+
+private:
+    SpinLock lock_;
+    // serialises snapshots, which reuse the buffers of the previous one
+    std::mutex snapshot_lock_;
+    typename Stamper::Snapshot snapshot_;
+};
+
+/*
+ * Periodically takes snapshots of a stamper on a background thread, and reports the stats over
+ * rolling windows (e.g. the last 10s and the last 1min) to a sink.
+ */
+template <typename Token>
+class LiveReporter
+{
+public:
+    using Collection = TimeStampCollection<Token>;
+    using Clock = std::chrono::steady_clock;
+    // called with the label of a window (e.g. "last 10s") and the stats within that window
+    using Sink = std::function<void(const std::string &, const Collection &)>;
+
+    /*
+     * Snapshots are taken every `tick`, and all windows are reported every `report_every`.
+     */
+    LiveReporter(
+        std::function<Collection()> take_snapshot, Sink sink,
+        std::vector<std::chrono::milliseconds> windows =
+            {std::chrono::seconds(10), std::chrono::minutes(1)},
+        std::chrono::milliseconds report_every = std::chrono::seconds(10),
+        std::chrono::milliseconds tick = std::chrono::seconds(1)
+    )
+      : take_snapshot_(std::move(take_snapshot))
+      , sink_(std::move(sink))
+      , windows_(std::move(windows))
+      , report_every_(report_every)
+      , tick_(tick)
+    {
+        if (windows_.empty())
+            throw std::runtime_error("LiveReporter needs at least one window");
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    /*
+     * Report the snapshots of a stamper (e.g. a LiveStamper), which must outlive the reporter.
+     */
+    template <typename S>
+    LiveReporter(
+        S &stamper, Sink sink,
+        std::vector<std::chrono::milliseconds> windows =
+            {std::chrono::seconds(10), std::chrono::minutes(1)},
+        std::chrono::milliseconds report_every = std::chrono::seconds(10),
+        std::chrono::milliseconds tick = std::chrono::seconds(1)
+    )
+      : LiveReporter(
+            [&stamper]() { return stamper.snapshot_and_reset(); }, std::move(sink),
+            std::move(windows), report_every, tick
+        )
+    {
+    }
+
+    ~LiveReporter()
+    {
+        stop();
+    }
+
+    LiveReporter(const LiveReporter &) = delete;
+    LiveReporter &operator=(const LiveReporter &) = delete;
+
+    /*
+     * Stop the background thread, after a final snapshot and report.
+     */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (stopped_)
+                return;
+            stopped_ = true;
+        }
+        wake_up_.notify_all();
+        thread_.join();
+    }
+
+    static std::string window_label(std::chrono::milliseconds window)
+    {
+        if (window.count() % 60000 == 0)
+            return "last " + std::to_string(window.count() / 60000) + "min";
+        if (window.count() % 1000 == 0)
+            return "last " + std::to_string(window.count() / 1000) + "s";
+        return "last " + std::to_string(window.count()) + "ms";
+    }
+
+protected:
+    void run()
+    {
+        auto next_report = Clock::now() + report_every_;
+        while (true)
+        {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                stopping = wake_up_.wait_for(guard, tick_, [this]() { return stopped_; });
+            }
+
+            const auto now = Clock::now();
+            snapshots_.emplace_back(now, take_snapshot_());
+            const auto longest = *std::max_element(windows_.begin(), windows_.end());
+            while (!snapshots_.empty() && now - snapshots_.front().first > longest)
+                snapshots_.pop_front();
+
+            if (stopping || now >= next_report)
+            {
+                report(now);
+                next_report = now + report_every_;
+            }
+            if (stopping)
+                return;
+        }
+    }
+
+    void report(Clock::time_point now)
+    {
+        for (auto &&window : windows_)
+        {
+            Collection merged;
+            for (auto &&snapshot : snapshots_)
+            {
+                if (now - snapshot.first > window)
+                    continue;
+                for (auto &&item : snapshot.second)
+                    merged[item.first].accumulate_standard(item.second);
+            }
+            sink_(window_label(window), merged);
+        }
+    }
+
+    std::function<Collection()> take_snapshot_;
+    Sink sink_;
+    std::vector<std::chrono::milliseconds> windows_;
+    std::chrono::milliseconds report_every_;
+    std::chrono::milliseconds tick_;
+
+    std::deque<std::pair<Clock::time_point, Collection>> snapshots_;
+    std::mutex lock_;
+    std::condition_variable wake_up_;
+    bool stopped_ = false;
+    std::thread thread_;
+};
+
+/*
+ * A sink that prints each window with print_compiled_stats.
+ */
+template <typename Token>
+typename LiveReporter<Token>::Sink print_sink()
+{
+    return [](const std::string &window, const TimeStampCollection<Token> &stats)
+    {
+        sxs::println("[", window, "]");
+        if (!stats.empty())
+            print_compiled_stats(stats);
+    };
+}
+
+/*
+ * A sink that appends a csv row per token pair and window. The stream must outlive the reporter.
+ */
+template <typename Token>
+typename LiveReporter<Token>::Sink csv_sink(std::ostream &stream, bool write_header = true)
+{
+    if (write_header)
+        stream << "time,window,from,to,count,mean,stdev,min,max,sum" << std::endl;
+    return [&stream](const std::string &window, const TimeStampCollection<Token> &stats)
+    {
+        using secs = std::chrono::duration<double>;
+        const double time = secs(std::chrono::system_clock::now().time_since_epoch()).count();
+        for (auto &&item : stats)
+        {
+            stream << std::fixed << time << "," << window << ",\""
+                   << sxs::stats::get_token_name(item.first.first) << "\",\""
+                   << sxs::stats::get_token_name(item.first.second) << "\","
+                   << item.second.count << "," << std::scientific << item.second.mean() << ","
+                   << item.second.stdev() << "," << item.second.min << "," << item.second.max
+                   << "," << item.second.sum << std::defaultfloat << "\n";
+        }
+        stream.flush();
+    };
+}
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/string.h"
+
+#include <sstream>
+
+namespace __sxs_live_report
+{
+
+TEST_CASE("[sxs] Snapshot a stamper while it keeps stamping")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::LiveStamper<sxs::TimeStamper<int>> timer;
+    timer.set_autoprint(false);
+
+    constexpr size_t num_loops = 20000;
+    std::atomic<bool> done{false};
+    std::thread stamping(
+        [&]()
+        {
+            for (size_t i = 0; i < num_loops; ++i)
+            {
+                timer.stamp<0>();
+                timer.stamp<1>();
+            }
+            done = true;
+        }
+    );
+
+    size_t total = 0;
+    while (!done)
+    {
+        for (auto &&item : timer.snapshot_and_reset())
+            total += item.second.count;
+    }
+    stamping.join();
+    for (auto &&item : timer.snapshot_and_reset())
+        total += item.second.count;
+    // no interval is lost or counted twice across snapshots
+    CHECK(total == 2 * num_loops - 1);
+}
+
+TEST_CASE("[sxs] Live reporter with rolling windows")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+    using namespace std::chrono_literals;
+
+    sxs::LiveStamper<sxs::TimeStamperDynamic> timer;
+    timer.set_autoprint(false);
+
+    std::mutex lock;
+    std::vector<std::string> windows;
+    size_t num_reported = 0;
+    std::stringstream csv;
+    {
+        auto to_csv = sxs::csv_sink<sxs::InternedString>(csv);
+        sxs::LiveReporter<sxs::InternedString> reporter(
+            timer,
+            [&](const std::string &window, const auto &stats)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                windows.push_back(window);
+                for (auto &&item : stats)
+                    num_reported += item.second.count;
+                to_csv(window, stats);
+            },
+            {20ms, 1s}, 20ms, 5ms
+        );
+        for (int i = 0; i < 20; ++i)
+        {
+            timer.stamp("live begin");
+            std::this_thread::sleep_for(2ms);
+            timer.stamp("live end");
+        }
+    }
+
+    CHECK(windows.size() >= 2);
+    CHECK(windows[0] == "last 20ms");
+    CHECK(windows[1] == "last 1s");
+    CHECK(num_reported > 0);
+    CHECK(sxs::string::contains(csv.str(), "time,window,from,to,count"));
+    CHECK(sxs::string::contains(csv.str(), "\"live begin\",\"live end\""));
+
+    sxs::print_sink<int>()("last 10s", sxs::TimeStampCollection<int>{});
+    CHECK(sxs::string::contains(guard.oss().str(), "[last 10s]"));
+
+    CHECK_THROWS_AS(
+        sxs::LiveReporter<sxs::InternedString>(timer, sxs::print_sink<sxs::InternedString>(), {}),
+        const std::runtime_error &
+    );
+}
+
+}  // namespace __sxs_live_report
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,589 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "token.h"
+
+#include "../simple_sockets.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * Formats metrics in the Prometheus text exposition format (version 0.0.4), see
+ * https://prometheus.io/docs/instrumenting/exposition_formats/
+ */
+class PrometheusWriter
+{
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    /*
+     * Write the TYPE line of a metric, once, before its first sample.
+     */
+    void type(const std::string &name, const char *type)
+    {
+        if (declared_.insert(name).second)
+            stream_ << "# TYPE " << name << " " << type << "\n";
+    }
+
+    void sample(const std::string &name, double value, const Labels &labels = {})
+    {
+        stream_ << name;
+        if (!labels.empty())
+        {
+            stream_ << "{";
+            for (size_t i = 0; i < labels.size(); ++i)
+                stream_ << (i > 0 ? "," : "") << labels[i].first << "=\""
+                        << escape_label(labels[i].second) << "\"";
+            stream_ << "}";
+        }
+        stream_ << " " << format_value(value) << "\n";
+    }
+
+    void gauge(const std::string &name, double value, const Labels &labels = {})
+    {
+        type(name, "gauge");
+        sample(name, value, labels);
+    }
+
+    /*
+     * The value of every key of a sxs::Stats (or anything with a matching for_each_item()), as a
+     * gauge with the key as its label.
+     */
+    template <typename StatsLike>
+    void stats(const StatsLike &stats, const std::string &name = "sxs_stats")
+    {
+        type(name, "gauge");
+        stats.for_each_item(
+            [this, &name](const std::string &key, const auto &value)
+            {
+                std::visit(
+                    [this, &name, &key](const auto &x)
+                    { sample(name, static_cast<double>(x), {{"key", key}}); },
+                    value
+                );
+            }
+        );
+    }
+
+    /*
+     * Compiled timings, as a summary (in seconds) per pair of tokens, with quantiles if the
+     * stats have a histogram, and gauges of their min and max.
+     */
+    template <typename Collection>
+    void timings(const Collection &collection, const std::string &name = "sxs_timing_seconds")
+    {
+        auto labels_of = [](const auto &key) -> Labels
+        {
+            return {
+                {"from", std::string(sxs::stats::get_token_name(key.first))},
+                {"to", std::string(sxs::stats::get_token_name(key.second))}};
+        };
+
+        type(name, "summary");
+        for (auto &&item : collection)
+        {
+            const Labels labels = labels_of(item.first);
+            if (item.second.histogram)
+            {
+                for (auto quantile : {0.5, 0.9, 0.99})
+                {
+                    Labels with_quantile = labels;
+                    with_quantile.emplace_back("quantile", format_value(quantile));
+                    sample(name, item.second.percentile(quantile * 100), with_quantile);
+                }
+            }
+            sample(name + "_sum", item.second.sum, labels);
+            sample(name + "_count", static_cast<double>(item.second.count), labels);
+        }
+        type(name + "_min", "gauge");
+        for (auto &&item : collection)
+            sample(name + "_min", item.second.min, labels_of(item.first));
+        type(name + "_max", "gauge");
+        for (auto &&item : collection)
+            sample(name + "_max", item.second.max, labels_of(item.first));
+    }
+
+    std::string str() const
+    {
+        return stream_.str();
+    }
+
+    static std::string escape_label(const std::string &value)
+    {
+        std::string escaped;
+        for (auto &&c : value)
+        {
+            if (c == '\\' || c == '"')
+                escaped += {'\\', c};
+            else if (c == '\n')
+                escaped += "\\n";
+            else
+                escaped += c;
+        }
+        return escaped;
+    }
+
+    static std::string format_value(double value)
+    {
+        if (std::isnan(value))
+            return "NaN";
+        if (std::isinf(value))
+            return value > 0 ? "+Inf" : "-Inf";
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        return buffer;
+    }
+
+protected:
+    std::stringstream stream_;
+    std::unordered_set<std::string> declared_;
+};
+
+/*
+ * A minimal HTTP/1.1 responder on a TCPServer, which serves `GET /metrics` in the Prometheus text
+ * format from a background thread, e.g. to be scraped by Prometheus or `curl host:port/metrics`.
+ *
+ * Metrics are written on each request by the registered collectors, which only read the sources:
+ * a Stats is read as is (see Stats::for_each_item()), and a LiveStamper hands over its intervals
+ * with the swap of two vectors, so the threads that update them are never blocked. Requests are
+ * served one at a time, and each connection is closed after its response, or once it has been
+ * idle for the given timeout, so a stalled client cannot hold up the server.
+ */
+class MetricsServer : public simple_socket::TCPServer
+{
+public:
+    using Collector = std::function<void(PrometheusWriter &)>;
+
+    /*
+     * Listen on the given port (0 picks a free one, see port()) and start serving.
+     */
+    explicit MetricsServer(
+        u_short port = 9464, const std::string &ip_address = "0.0.0.0",
+        std::chrono::milliseconds timeout = std::chrono::seconds(5)
+    )
+      : TCPServer(port, ip_address), m_timeout(timeout)
+    {
+        int reuse = 1;
+        setsockopt(
+            m_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&reuse),
+            sizeof(reuse)
+        );
+        if (bind(m_socket, reinterpret_cast<sockaddr *>(&m_addr), sizeof(m_addr)) == SOCKET_ERROR ||
+            listen(m_socket, 8) == SOCKET_ERROR)
+        {
+            LOG_WIN_SOCKET_ERROR();
+            CLOSE_SOCKET(m_socket);
+            throw std::runtime_error("Unable to serve metrics on port " + std::to_string(port));
+        }
+        m_thread = std::thread(&MetricsServer::loop, this);
+    }
+
+    ~MetricsServer()
+    {
+        stop();
+    }
+
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+    void stop()
+    {
+        if (m_stopping.exchange(true))
+            return;
+        // wakes up the blocking accept(), or the recv() or send() of a connection
+        {
+            std::lock_guard<std::mutex> guard(m_client_lock);
+            if (m_client != INVALID_SOCKET)
+                SHUTDOWN_SOCKET(m_client);
+        }
+        SHUTDOWN_SOCKET(m_socket);
+        m_thread.join();
+        CLOSE_SOCKET(m_socket);
+    }
+
+    u_short port() const
+    {
+        sockaddr_in addr;
+        socklen_t addr_size = sizeof(addr);
+        getsockname(m_socket, reinterpret_cast<sockaddr *>(&addr), &addr_size);
+        return ntohs(addr.sin_port);
+    }
+
+    void add_collector(Collector collector)
+    {
+        std::lock_guard<std::mutex> guard(m_collectors_lock);
+        m_collectors.push_back(std::move(collector));
+    }
+
+    /*
+     * Serve the values of a sxs::Stats, which must outlive the server. Every request reads it, so
+     * the same rules apply as to reading it while other threads update it (see sxs::Stats).
+     */
+    template <typename StatsLike>
+    void add_stats(const StatsLike &stats, const std::string &name = "sxs_stats")
+    {
+        add_collector([&stats, name](PrometheusWriter &writer) { writer.stats(stats, name); });
+    }
+
+    /*
+     * Serve the timings of a LiveStamper, which must outlive the server. Every request takes the
+     * intervals stamped since the previous one, and serves the totals since the server started.
+     */
+    template <typename Stamper>
+    void add_live_stamper(Stamper &stamper, const std::string &name = "sxs_timing_seconds")
+    {
+        using Collection = decltype(stamper.snapshot_and_reset());
+        auto totals = std::make_shared<Collection>();
+        add_collector(
+            [&stamper, totals, name](PrometheusWriter &writer)
+            {
+                for (auto &&item : stamper.snapshot_and_reset())
+                    (*totals)[item.first].accumulate_standard(item.second);
+                writer.timings(*totals, name);
+            }
+        );
+    }
+
+    /*
+     * The body of a response to `GET /metrics`.
+     */
+    std::string render()
+    {
+        PrometheusWriter writer;
+        std::lock_guard<std::mutex> guard(m_collectors_lock);
+        for (auto &&collector : m_collectors)
+            collector(writer);
+        return writer.str();
+    }
+
+protected:
+    void loop()
+    {
+        while (!m_stopping)
+        {
+            if (accept_new_client())
+                continue;
+            set_client_options();
+            {
+                std::lock_guard<std::mutex> guard(m_client_lock);
+                m_client = connected_socket;
+            }
+            if (!m_stopping)
+                respond(read_request());
+            std::lock_guard<std::mutex> guard(m_client_lock);
+            m_client = INVALID_SOCKET;
+            CLOSE_SOCKET(connected_socket);
+        }
+    }
+
+    void set_client_options() const
+    {
+#ifdef _WIN32
+        const DWORD timeout = static_cast<DWORD>(m_timeout.count());
+#else
+        timeval timeout;
+        timeout.tv_sec = static_cast<decltype(timeout.tv_sec)>(m_timeout.count() / 1000);
+        timeout.tv_usec = static_cast<decltype(timeout.tv_usec)>(m_timeout.count() % 1000 * 1000);
+#endif
+        for (int option : {SO_RCVTIMEO, SO_SNDTIMEO})
+            setsockopt(
+                connected_socket, SOL_SOCKET, option, reinterpret_cast<const char *>(&timeout),
+                sizeof(timeout)
+            );
+#ifdef SO_NOSIGPIPE
+        // a client that hung up must not kill the process with a SIGPIPE, without MSG_NOSIGNAL
+        int no_sigpipe = 1;
+        setsockopt(connected_socket, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+    }
+
+    // the request line and headers, which is all a GET has
+    std::string read_request() const
+    {
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 16384)
+        {
+            const ssize_t length = recv(connected_socket, buffer, sizeof(buffer), 0);
+            if (length <= 0)
+                break;
+            request.append(buffer, length);
+        }
+        return request;
+    }
+
+    void respond(const std::string &request)
+    {
+        const auto path_start = request.find(' ');
+        const auto path_end = request.find_first_of(" ?", path_start + 1);
+        const bool is_get = request.compare(0, path_start, "GET") == 0;
+        const bool is_metrics =
+            path_start != std::string::npos && path_end != std::string::npos &&
+            request.compare(path_start + 1, path_end - path_start - 1, "/metrics") == 0;
+
+        std::string status = "200 OK", content_type = "text/plain; version=0.0.4", body;
+        if (!is_get)
+        {
+            status = "405 Method Not Allowed";
+            content_type = "text/plain";
+            body = "Only GET is supported\n";
+        }
+        else if (!is_metrics)
+        {
+            status = "404 Not Found";
+            content_type = "text/plain";
+            body = "Metrics are served at /metrics\n";
+        }
+        else
+            body = render();
+
+        send_all(
+            "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+            "; charset=utf-8\r\nContent-Length: " + std::to_string(body.size()) +
+            "\r\nConnection: close\r\n\r\n" + body
+        );
+    }
+
+    void send_all(const std::string &response) const
+    {
+#ifdef MSG_NOSIGNAL
+        // a client that hung up must not kill the process with a SIGPIPE
+        constexpr int flags = MSG_NOSIGNAL;
+#else
+        constexpr int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < response.size())
+        {
+            const ssize_t length =
+                send(connected_socket, response.data() + sent, response.size() - sent, flags);
+            if (length <= 0)
+                return;
+            sent += length;
+        }
+    }
+
+    std::chrono::milliseconds m_timeout;
+    std::atomic<bool> m_stopping{false};
+    std::thread m_thread;
+    // the connection being served, if any, for stop() to wake it up
+    std::mutex m_client_lock;
+    SOCKET m_client = INVALID_SOCKET;
+    std::mutex m_collectors_lock;
+    std::vector<Collector> m_collectors;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/string.h"
+
+#include <limits>
+
+// the Stats of soraxas_toolbox/stats.h cannot be included next to the timers, so its metrics are
+// tested along with the stats (see tests/stats_runner.cpp), and the timings otherwise
+#ifndef SXS_STATS_H
+#include "live_report.h"
+#endif
+
+namespace __sxs_metrics_server
+{
+
+// a connected client, which sends nothing yet (or INVALID_SOCKET without loopback networking)
+SOCKET connect_to(u_short port)
+{
+    const SOCKET client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        CLOSE_SOCKET(client);
+        return INVALID_SOCKET;
+    }
+    return client;
+}
+
+// a plain socket client, as `curl http://127.0.0.1:port/path` would be
+std::string http_get(u_short port, const std::string &path, const std::string &method = "GET")
+{
+    const SOCKET client = connect_to(port);
+    if (client == INVALID_SOCKET)
+        return "";
+    const std::string request = method + " " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(client, request.data(), request.size(), 0);
+
+    std::string response;
+    char buffer[1024];
+    ssize_t length;
+    while ((length = recv(client, buffer, sizeof(buffer), 0)) > 0)
+        response.append(buffer, length);
+    CLOSE_SOCKET(client);
+    return response;
+}
+
+TEST_CASE("[sxs] Prometheus metrics")
+{
+    CHECK(sxs::PrometheusWriter::escape_label("a\"b\\c\n") == "a\\\"b\\\\c\\n");
+    CHECK(sxs::PrometheusWriter::format_value(0.5) == "0.5");
+    CHECK(sxs::PrometheusWriter::format_value(std::numeric_limits<double>::infinity()) == "+Inf");
+
+    sxs::MetricsServer server(0, "127.0.0.1");
+    int requests = 0;
+    server.add_collector([&requests](sxs::PrometheusWriter &writer)
+                         { writer.gauge("sxs_requests", ++requests, {{"path", "/metrics"}}); });
+    CHECK(server.render() == "# TYPE sxs_requests gauge\nsxs_requests{path=\"/metrics\"} 1\n");
+
+    const std::string response = http_get(server.port(), "/metrics");
+    if (response.empty())
+        return;  // no loopback networking
+    CHECK(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    CHECK(sxs::string::contains(response, "Content-Type: text/plain; version=0.0.4"));
+    CHECK(sxs::string::contains(response, "sxs_requests{path=\"/metrics\"} 2\n"));
+    CHECK(http_get(server.port(), "/other").rfind("HTTP/1.1 404 Not Found\r\n", 0) == 0);
+    CHECK(
+        http_get(server.port(), "/metrics", "POST")
+            .rfind("HTTP/1.1 405 Method Not Allowed\r\n", 0) == 0
+    );
+
+    SUBCASE("stop while a client stalls")
+    {
+        const SOCKET client = connect_to(server.port());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const auto start = std::chrono::steady_clock::now();
+        server.stop();
+        // rather than after the timeout of the connection
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+        CLOSE_SOCKET(client);
+    }
+
+    SUBCASE("a stalled client times out")
+    {
+        sxs::MetricsServer quick_server(0, "127.0.0.1", std::chrono::milliseconds(50));
+        quick_server.add_collector([](sxs::PrometheusWriter &writer)
+                                   { writer.gauge("sxs_quick", 1); });
+        const SOCKET client = connect_to(quick_server.port());
+        CHECK(sxs::string::contains(http_get(quick_server.port(), "/metrics"), "sxs_quick 1\n"));
+        CLOSE_SOCKET(client);
+    }
+
+    SUBCASE("a client that hangs up before the response")
+    {
+        const SOCKET client = connect_to(server.port());
+        const std::string request = "GET /metrics HTTP/1.1\r\n\r\n";
+        send(client, request.data(), request.size(), 0);
+        CLOSE_SOCKET(client);
+        // the server is still alive, rather than killed by a SIGPIPE
+        CHECK(http_get(server.port(), "/metrics").rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    }
+    server.stop();
+}
+
+#ifdef SXS_STATS_H
+TEST_CASE("[sxs] Serve stats as Prometheus metrics")
+{
+    sxs::Stats stats(false);
+    stats.of("iterations") += 42;
+    stats.of("loss") = 0.25;
+
+    sxs::MetricsServer server(0, "127.0.0.1");
+    server.add_stats(stats);
+    const std::string body = server.render();
+    CHECK(sxs::string::contains(body, "# TYPE sxs_stats gauge\n"));
+    CHECK(sxs::string::contains(body, "sxs_stats{key=\"iterations\"} 42\n"));
+    CHECK(sxs::string::contains(body, "sxs_stats{key=\"loss\"} 0.25\n"));
+
+    stats.of("iterations") += 1;
+    const std::string response = http_get(server.port(), "/metrics");
+    server.stop();
+    stats.reset();
+    if (response.empty())
+        return;  // no loopback networking
+    CHECK(sxs::string::contains(response, "sxs_stats{key=\"iterations\"} 43\n"));
+}
+#else
+TEST_CASE("[sxs] Serve live timings as Prometheus metrics")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::LiveStamper<sxs::TimeStamperDynamic> timer;
+    timer.set_autoprint(false);
+    for (int i = 0; i < 3; ++i)
+    {
+        timer.stamp("metrics begin");
+        timer.stamp("metrics end");
+    }
+
+    sxs::MetricsServer server(0, "127.0.0.1");
+    server.add_live_stamper(timer);
+    const std::string body = server.render();
+    CHECK(sxs::string::contains(body, "# TYPE sxs_timing_seconds summary\n"));
+    CHECK(sxs::string::contains(
+        body, "sxs_timing_seconds_count{from=\"metrics begin\",to=\"metrics end\"} 3\n"
+    ));
+    CHECK(sxs::string::contains(body, "# TYPE sxs_timing_seconds_max gauge\n"));
+
+    // totals keep counting across requests
+    timer.stamp("metrics begin");
+    timer.stamp("metrics end");
+    const std::string response = http_get(server.port(), "/metrics");
+    if (response.empty())
+        return;  // no loopback networking
+    CHECK(sxs::string::contains(
+        response, "sxs_timing_seconds_count{from=\"metrics begin\",to=\"metrics end\"} 4\n"
+    ));
+}
+#endif
+
+}  // namespace __sxs_metrics_server
+#endif  // SXS_RUN_TESTS
@@ -0,0 +1,291 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if defined(__linux__) && defined __has_include
+#if __has_include(<linux/perf_event.h>)
+#define SXS_HAS_PERF_EVENTS
+#endif
+#endif
+
+#ifdef SXS_HAS_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * A group of perf_event counters of the calling thread, which are all read with a single syscall.
+ *
+ * Hardware counters (cycles, instructions, cache-misses, branch-misses) are used when the kernel
+ * and the cpu allow it, e.g., not in most VMs or with a high perf_event_paranoid. Software counters
+ * (page-faults, context-switches) are always tried, with task-clock standing in as the group leader
+ * when no hardware counter could be opened. Without perf events (e.g. not on Linux), the set is
+ * simply empty. Hardware counters only count user space, while software counters also count the
+ * kernel's work on behalf of the thread where permitted (see try_open()).
+ */
+class PerfCounterSet
+{
+public:
+    static constexpr size_t max_counters = 8;
+    using Values = std::array<uint64_t, max_counters>;
+
+    PerfCounterSet()
+    {
+#ifdef SXS_HAS_PERF_EVENTS
+        try_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles");
+        try_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions");
+        try_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache-misses");
+        try_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch-misses");
+        if (fds_.empty())
+            try_open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-clock");
+        try_open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page-faults");
+        // context switches only ever happen in the kernel
+        try_open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context-switches", true);
+        if (!fds_.empty())
+        {
+            ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    ~PerfCounterSet()
+    {
+#ifdef SXS_HAS_PERF_EVENTS
+        for (auto &&fd : fds_)
+            close(fd);
+#endif
+    }
+
+    PerfCounterSet(const PerfCounterSet &) = delete;
+    PerfCounterSet &operator=(const PerfCounterSet &) = delete;
+
+    bool available() const
+    {
+        return !fds_.empty();
+    }
+
+    bool has_hardware_counters() const
+    {
+        return available() && names_[0] == "cycles";
+    }
+
+    size_t size() const
+    {
+        return fds_.size();
+    }
+
+    const std::string &name(size_t i) const
+    {
+        return names_[i];
+    }
+
+    /*
+     * Current value of each counter, in the order of name(i).
+     */
+    inline void read(Values &values) const
+    {
+#ifdef SXS_HAS_PERF_EVENTS
+        if (fds_.empty())
+            return;
+        // PERF_FORMAT_GROUP layout: [number of counters, value of each counter]
+        uint64_t buffer[1 + max_counters];
+        if (::read(fds_[0], buffer, sizeof(buffer)) > 0)
+            std::memcpy(values.data(), buffer + 1, buffer[0] * sizeof(uint64_t));
+#endif
+    }
+
+    /*
+     * Format the mean of each counter over `count` intervals, e.g. " {cycles 1.2M|...|IPC 1.50}".
+     */
+    std::string format(const Values &sums, size_t count) const
+    {
+        if (!available() || count == 0)
+            return "";
+        std::stringstream ss;
+        ss << " {";
+        for (size_t i = 0; i < size(); ++i)
+        {
+            if (i > 0)
+                ss << "|";
+            ss << names_[i] << " " << format_count(static_cast<double>(sums[i]) / count);
+        }
+        // the cycles and instructions leading the group, unless instructions could not be opened
+        if (has_hardware_counters() && size() > 1 && names_[1] == "instructions" && sums[0] > 0)
+            ss << "|IPC " << std::fixed << std::setprecision(2)
+               << static_cast<double>(sums[1]) / sums[0];
+        ss << "}";
+        return ss.str();
+    }
+
+    static std::string format_count(double value)
+    {
+        static constexpr std::array<const char *, 4> suffixes = {"", "k", "M", "G"};
+        size_t i = 0;
+        while (value >= 1000 && i + 1 < suffixes.size())
+        {
+            value /= 1000;
+            ++i;
+        }
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(i == 0 && value == std::floor(value) ? 0 : 2) << value
+           << suffixes[i];
+        return ss.str();
+    }
+
+private:
+#ifdef SXS_HAS_PERF_EVENTS
+    /*
+     * Hardware events only count user space. Software events also count what the kernel does on
+     * behalf of this thread where permitted (perf_event_paranoid < 2), and otherwise fall back to
+     * user space only, unless they would never count anything there.
+     */
+    void try_open(uint32_t type, uint64_t config, const char *name, bool kernel_only = false)
+    {
+        if (fds_.size() >= max_counters)
+            return;
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = type != PERF_TYPE_SOFTWARE;
+        attr.exclude_hv = 1;
+        // the group is enabled at once by its leader
+        attr.disabled = fds_.empty();
+        int fd = open_event(attr);
+        if (fd < 0 && !attr.exclude_kernel && !kernel_only)
+        {
+            attr.exclude_kernel = 1;
+            fd = open_event(attr);
+        }
+        if (fd < 0)
+            return;
+        fds_.push_back(fd);
+        names_.emplace_back(name);
+    }
+
+    int open_event(perf_event_attr &attr) const
+    {
+        return syscall(
+            __NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */,
+            fds_.empty() ? -1 : fds_[0], 0
+        );
+    }
+#endif
+
+    std::vector<int> fds_;
+    std::vector<std::string> names_;
+};
+
+/*
+ * Sums of counter deltas over a number of intervals.
+ */
+struct PerfCounterTotals
+{
+    PerfCounterSet::Values sums{};
+    size_t count = 0;
+
+    inline void add(const PerfCounterSet::Values &from, const PerfCounterSet::Values &to)
+    {
+        for (size_t i = 0; i < sums.size(); ++i)
+            sums[i] += to[i] - from[i];
+        ++count;
+    }
+
+    inline void merge(const PerfCounterTotals &other)
+    {
+        for (size_t i = 0; i < sums.size(); ++i)
+            sums[i] += other.sums[i];
+        count += other.count;
+    }
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <chrono>
+#include <thread>
+
+namespace __sxs_perf_counters
+{
+
+TEST_CASE("[sxs] Perf counters")
+{
+    CHECK(sxs::PerfCounterSet::format_count(12) == "12");
+    CHECK(sxs::PerfCounterSet::format_count(1234) == "1.23k");
+    CHECK(sxs::PerfCounterSet::format_count(2.5e9) == "2.50G");
+
+    sxs::PerfCounterSet counters;
+    if (!counters.available())
+        return;
+
+    sxs::PerfCounterSet::Values before{}, after{};
+    counters.read(before);
+    // touch fresh memory, which page faults
+    std::vector<char> memory(1 << 24);
+    for (size_t i = 0; i < memory.size(); i += 4096)
+        memory[i] = static_cast<char>(i);
+    // and give up the cpu, which context switches
+    for (int i = 0; i < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    counters.read(after);
+
+    sxs::PerfCounterTotals totals;
+    totals.add(before, after);
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        if (counters.name(i) == "page-faults" || counters.name(i) == "context-switches")
+            CHECK(totals.sums[i] > 0);
+    }
+    CHECK(counters.format(totals.sums, 1).find(counters.name(0)) != std::string::npos);
+}
+
+}  // namespace __sxs_perf_counters
+#endif  // SXS_RUN_TESTS
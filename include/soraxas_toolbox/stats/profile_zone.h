@@ -0,0 +1,531 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "perf_counters.h"
+#include "timing.h"
+
+#include "../clock.h"
+#include "../print_utils_core.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * A call-tree of nested profiling zones, with the call count, inclusive time and exclusive
+ * (self) time of each zone.
+ *
+ * Each thread owns its own tree (see get_thread_profile_tree()) and is the only one writing to it.
+ * Trees of other threads should only be read once those threads are done.
+ */
+class ProfileTree
+{
+public:
+    using clock_ = clock_policy::default_clock;
+
+    struct Node
+    {
+        std::string name;
+        // pointer to the name literal that created this node, for a fast comparison
+        const char *key;
+        size_t parent;
+        std::vector<size_t> children;
+        Stats<double> inclusive;
+        Stats<double> exclusive;
+        // inclusive counter deltas, only when counters are enabled
+        PerfCounterTotals counters;
+    };
+
+    // a single timed entry of a zone, only kept when recording events
+    struct Event
+    {
+        size_t node;
+        clock_::time_point start;
+        clock_::duration duration;
+    };
+
+    ProfileTree()
+    {
+        // root node, never timed
+        nodes_.push_back(Node{"", nullptr, 0, {}, {}, {}, {}});
+    }
+
+    /*
+     * Enter a child zone of the current zone. The name is expected to be a string literal.
+     */
+    inline void enter(const char *name)
+    {
+        const size_t parent = frames_.empty() ? 0 : frames_.back().node;
+        frames_.push_back(Frame{find_or_create_child(parent, name), {}, {}, {}});
+        if (counters_)
+            counters_->read(frames_.back().start_counters);
+        frames_.back().start = clock_::now();
+    }
+
+    /*
+     * Exit the current zone. Exiting with no open zone is ignored.
+     */
+    inline void exit()
+    {
+        const auto now = clock_::now();
+        if (frames_.empty())
+            return;
+        const Frame &frame = frames_.back();
+        const auto inclusive = now - frame.start;
+
+        Node &node = nodes_[frame.node];
+        if (counters_)
+        {
+            PerfCounterSet::Values end_counters;
+            counters_->read(end_counters);
+            node.counters.add(frame.start_counters, end_counters);
+        }
+        node.inclusive.add(clock_::to_secs(inclusive));
+        node.exclusive.add(clock_::to_secs(inclusive - frame.children));
+        if (record_events_)
+            events_.push_back(Event{frame.node, frame.start, inclusive});
+        frames_.pop_back();
+        if (!frames_.empty())
+            frames_.back().children += inclusive;
+    }
+
+    const std::vector<Node> &nodes() const
+    {
+        return nodes_;
+    }
+
+    /*
+     * Also keep every timed entry of every zone (rather than only their stats), such that they
+     * can be placed on a timeline. Costs memory per zone entry.
+     */
+    void set_record_events(bool record_events = true)
+    {
+        record_events_ = record_events;
+    }
+
+    const std::vector<Event> &events() const
+    {
+        return events_;
+    }
+
+    /*
+     * Also read perf_event counters (see PerfCounterSet) when entering and exiting zones, and
+     * report their mean inclusive delta per zone. Must be called from the thread that owns the
+     * tree. Returns false if no counter is available.
+     */
+    bool enable_counters()
+    {
+        counters_ = std::make_shared<PerfCounterSet>();
+        if (!counters_->available())
+            counters_.reset();
+        return counters_ != nullptr;
+    }
+
+    // the counters that were enabled, if any, which name the values of Node::counters
+    const std::shared_ptr<const PerfCounterSet> &counters() const
+    {
+        return counters_;
+    }
+
+    const Node &root() const
+    {
+        return nodes_[0];
+    }
+
+    /*
+     * Total inclusive time of all top-level zones.
+     */
+    double total_time() const
+    {
+        double total = 0;
+        for (auto &&child : root().children)
+            total += nodes_[child].inclusive.sum;
+        return total;
+    }
+
+    size_t depth_of(size_t index) const
+    {
+        size_t depth = 0;
+        while (index != 0)
+        {
+            index = nodes_[index].parent;
+            ++depth;
+        }
+        return depth;
+    }
+
+    /*
+     * Merge another tree (e.g. from another thread) into this one, matching zones by their path.
+     */
+    void merge(const ProfileTree &other)
+    {
+        merge_node(0, other, 0);
+        if (!counters_)
+            counters_ = other.counters_;
+    }
+
+    /*
+     * Discard all stats. Zones that are still open stay open (under the same path), and are
+     * timed from when they were entered.
+     */
+    void reset()
+    {
+        std::vector<Node> old_nodes;
+        old_nodes.swap(nodes_);
+        nodes_.push_back(Node{"", nullptr, 0, {}, {}, {}, {}});
+        size_t parent = 0;
+        for (auto &&frame : frames_)
+        {
+            const Node &old = old_nodes[frame.node];
+            frame.node = find_or_create_child(parent, old.key);
+            nodes_[frame.node].name = old.name;
+            parent = frame.node;
+        }
+        events_.clear();
+    }
+
+    /*
+     * Write the exclusive time of every zone path in the folded stacks format, i.e.,
+     * `outer;inner <microseconds>` per line, as consumed by flamegraph.pl and speedscope.
+     */
+    void to_folded_stacks(std::ostream &stream) const
+    {
+        for (auto &&child : root().children)
+            folded_stacks_of(child, "", stream);
+    }
+
+    /*
+     * Depth-first visit of all zones (excluding root), in the order they were first entered.
+     */
+    template <typename F>
+    void visit(const F &functor, size_t index = 0) const
+    {
+        for (auto &&child : nodes_[index].children)
+        {
+            functor(child, nodes_[child]);
+            visit(functor, child);
+        }
+    }
+
+protected:
+    struct Frame
+    {
+        size_t node;
+        clock_::duration children;
+        clock_::time_point start;
+        PerfCounterSet::Values start_counters;
+    };
+
+    size_t find_or_create_child(size_t parent, const char *name)
+    {
+        for (auto &&child : nodes_[parent].children)
+        {
+            const Node &node = nodes_[child];
+            if (node.key == name || node.name == name)
+                return child;
+        }
+        nodes_.push_back(Node{name, name, parent, {}, {}, {}, {}});
+        nodes_[parent].children.push_back(nodes_.size() - 1);
+        return nodes_.size() - 1;
+    }
+
+    void merge_node(size_t index, const ProfileTree &other, size_t other_index)
+    {
+        for (auto &&other_child : other.nodes_[other_index].children)
+        {
+            const Node &other_node = other.nodes_[other_child];
+            const size_t child = find_or_create_child(index, other_node.key);
+            nodes_[child].inclusive.accumulate_standard(other_node.inclusive);
+            nodes_[child].exclusive.accumulate_standard(other_node.exclusive);
+            nodes_[child].counters.merge(other_node.counters);
+            merge_node(child, other, other_child);
+        }
+    }
+
+    void folded_stacks_of(size_t index, const std::string &prefix, std::ostream &stream) const
+    {
+        const Node &node = nodes_[index];
+        const std::string path = prefix.empty() ? node.name : prefix + ";" + node.name;
+        const auto self_us = std::llround(node.exclusive.sum * 1e6);
+        if (self_us > 0)
+            stream << path << " " << self_us << "\n";
+        for (auto &&child : node.children)
+            folded_stacks_of(child, path, stream);
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<Frame> frames_;
+    std::vector<Event> events_;
+    bool record_events_ = false;
+    std::shared_ptr<const PerfCounterSet> counters_;
+};
+
+// all trees ever created, such that they outlive their threads for reporting
+inline std::mutex &get_profile_trees_lock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+inline std::vector<std::pair<std::thread::id, std::shared_ptr<ProfileTree>>> &get_profile_trees()
+{
+    static std::vector<std::pair<std::thread::id, std::shared_ptr<ProfileTree>>> trees;
+    return trees;
+}
+
+inline ProfileTree &get_thread_profile_tree()
+{
+    thread_local std::shared_ptr<ProfileTree> tree = []()
+    {
+        auto new_tree = std::make_shared<ProfileTree>();
+        std::lock_guard<std::mutex> guard(get_profile_trees_lock());
+        get_profile_trees().emplace_back(std::this_thread::get_id(), new_tree);
+        return new_tree;
+    }();
+    return *tree;
+}
+
+/*
+ * Merge the trees of all threads that had entered a zone.
+ */
+inline ProfileTree collect_profile_trees()
+{
+    ProfileTree merged;
+    std::lock_guard<std::mutex> guard(get_profile_trees_lock());
+    for (auto &&tree : get_profile_trees())
+        merged.merge(*tree.second);
+    return merged;
+}
+
+/*
+ * An RAII zone that is timed from construction to destruction, see SXS_PROFILE_SCOPE.
+ */
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name) : tree_(get_thread_profile_tree())
+    {
+        tree_.enter(name);
+    }
+
+    ~ProfileZone()
+    {
+        tree_.exit();
+    }
+
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    ProfileTree &tree_;
+};
+
+inline void print_profile_tree(const ProfileTree &tree)
+{
+    using sxs::format_time2readable;
+    size_t name_max_len = 0;
+    size_t stats_size_max_len = 0;
+    const double total_time_spent = tree.total_time();
+
+    tree.visit(
+        [&](size_t index, const ProfileTree::Node &node)
+        {
+            name_max_len =
+                std::max(name_max_len, 2 * (tree.depth_of(index) - 1) + node.name.size());
+            stats_size_max_len =
+                std::max(stats_size_max_len, std::to_string(node.inclusive.count).length());
+        }
+    );
+
+    sxs::println("========== profiled zones ==========");
+    tree.visit(
+        [&](size_t index, const ProfileTree::Node &node)
+        {
+            const std::string indent(2 * (tree.depth_of(index) - 1), ' ');
+            *sxs::get_print_output_stream()
+                << std::left                                                       //
+                << std::setw(name_max_len) << (indent + node.name)                 // zone
+                << ": " << format_time2readable(node.inclusive.mean_stdev())       // mean, stdev
+                << " (" << format_time2readable(node.inclusive.min) << "~"         // min
+                << format_time2readable(node.inclusive.max) << ")"                 // max
+                << " [Σ^" << std::setw(stats_size_max_len) << node.inclusive.count  // calls
+                << "=" << format_time2readable(node.inclusive.sum) << "|"          // inclusive
+                << _FIX_WIDTH_DECIMAL(3) << (node.inclusive.sum / total_time_spent * 100)
+                << "%] self " << format_time2readable(node.exclusive.sum) << "|"  // exclusive
+                << _FIX_WIDTH_DECIMAL(3) << (node.exclusive.sum / total_time_spent * 100) << "%"
+                << (tree.counters() ? tree.counters()->format(node.counters.sums,
+                                                              node.counters.count)
+                                    : "")
+                << std::endl;
+        }
+    );
+    sxs::println("====================================");
+}
+
+}  // namespace sxs
+
+#define SXS_PROFILE_SCOPE_CONCAT_INNER(a, b) a##b
+#define SXS_PROFILE_SCOPE_CONCAT(a, b) SXS_PROFILE_SCOPE_CONCAT_INNER(a, b)
+// profile the enclosing scope as a zone of the given name, nested under the current zone
+#define SXS_PROFILE_SCOPE(name)                                                                    \
+    ::sxs::ProfileZone SXS_PROFILE_SCOPE_CONCAT(__sxs_profile_zone_, __LINE__)(name)
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/string.h"
+
+#include <sstream>
+
+namespace __sxs_profile_zone
+{
+
+void inner_work()
+{
+    SXS_PROFILE_SCOPE("inner");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+TEST_CASE("[sxs] Nested profile zones")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::ProfileTree tree;
+    std::thread(
+        [&tree]()
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                SXS_PROFILE_SCOPE("outer");
+                inner_work();
+                inner_work();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            inner_work();
+            tree = sxs::get_thread_profile_tree();
+        }
+    ).join();
+
+    // root -> [outer -> [inner], inner]
+    const auto &root = tree.root();
+    REQUIRE(root.children.size() == 2);
+    const auto &outer = tree.nodes()[root.children[0]];
+    const auto &top_inner = tree.nodes()[root.children[1]];
+    REQUIRE(outer.children.size() == 1);
+    const auto &nested_inner = tree.nodes()[outer.children[0]];
+
+    CHECK(outer.name == "outer");
+    CHECK(outer.inclusive.count == 3);
+    CHECK(nested_inner.inclusive.count == 6);
+    CHECK(top_inner.inclusive.count == 1);
+
+    CHECK(outer.inclusive.sum >= nested_inner.inclusive.sum);
+    CHECK(
+        outer.exclusive.sum ==
+        doctest::Approx(outer.inclusive.sum - nested_inner.inclusive.sum).epsilon(1e-3)
+    );
+    CHECK(outer.exclusive.sum >= 3e-3);
+    CHECK(nested_inner.exclusive.sum == doctest::Approx(nested_inner.inclusive.sum));
+
+    std::stringstream folded;
+    tree.to_folded_stacks(folded);
+    CHECK(sxs::string::contains(folded.str(), "outer;inner "));
+
+    SUBCASE("merge trees")
+    {
+        sxs::ProfileTree merged;
+        merged.merge(tree);
+        merged.merge(tree);
+        CHECK(merged.nodes().size() == tree.nodes().size());
+        CHECK(merged.nodes()[outer.children[0]].inclusive.count == 12);
+        CHECK(sxs::collect_profile_trees().nodes().size() >= tree.nodes().size());
+    }
+
+    print_profile_tree(tree);
+    CHECK(sxs::string::contains(guard.oss().str(), "  inner"));
+}
+
+TEST_CASE("[sxs] Reset a profile tree with open zones")
+{
+    sxs::ProfileTree tree;
+    tree.enter("reset outer");
+    tree.enter("reset inner");
+    tree.reset();
+    CHECK(tree.nodes().size() == 3);
+    tree.exit();
+    tree.exit();
+    // unbalanced exits are ignored
+    tree.exit();
+
+    const auto &outer = tree.nodes()[tree.root().children.at(0)];
+    CHECK(outer.name == "reset outer");
+    CHECK(outer.inclusive.count == 1);
+    CHECK(tree.nodes()[outer.children.at(0)].inclusive.count == 1);
+}
+
+TEST_CASE("[sxs] Perf counters per profile zone")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::ProfileTree tree;
+    if (!tree.enable_counters())
+        return;
+    for (int i = 0; i < 3; ++i)
+    {
+        tree.enter("counted");
+        tree.enter("nested");
+        tree.exit();
+        tree.exit();
+    }
+    const auto &counted = tree.nodes()[tree.root().children[0]];
+    CHECK(counted.counters.count == 3);
+
+    sxs::print_profile_tree(tree);
+    CHECK(sxs::string::contains(guard.oss().str(), tree.counters()->name(0)));
+
+    sxs::ProfileTree merged;
+    merged.merge(tree);
+    merged.merge(tree);
+    CHECK(merged.nodes()[merged.root().children[0]].counters.count == 6);
+    CHECK(merged.counters() == tree.counters());
+}
+
+}  // namespace __sxs_profile_zone
+#endif  // SXS_RUN_TESTS
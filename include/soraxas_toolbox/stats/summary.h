@@ -0,0 +1,521 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../binary_io.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * A merging t-digest (Dunning & Ertl), a sketch of a distribution for estimating its quantiles,
+ * most accurately in its tails.
+ *
+ * Values are buffered, then merged into at most about `compression` centroids, so the memory is
+ * bounded regardless of how many values are added. Two digests can be merged into one.
+ */
+class TDigest
+{
+public:
+    struct Centroid
+    {
+        double mean;
+        double weight;
+    };
+
+    explicit TDigest(double compression = 100) : compression_(compression)
+    {
+    }
+
+    inline void add(double value, double weight = 1)
+    {
+        buffer_.push_back({value, weight});
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        if (buffer_.size() >= buffer_limit())
+            compress();
+    }
+
+    void merge(const TDigest &other)
+    {
+        other.compress();
+        buffer_.insert(buffer_.end(), other.centroids_.begin(), other.centroids_.end());
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        compress();
+    }
+
+    /*
+     * Estimated value at the quantile q (0 ~ 1), or NaN if empty.
+     */
+    double quantile(double q) const
+    {
+        compress();
+        if (centroids_.empty())
+            return std::numeric_limits<double>::quiet_NaN();
+        if (centroids_.size() == 1)
+            return centroids_[0].mean;
+
+        const double target = std::min(std::max(q, 0.), 1.) * total_weight_;
+        const Centroid &first = centroids_.front();
+        const Centroid &last = centroids_.back();
+        if (target < first.weight / 2)
+            return min_ + (first.mean - min_) * target / (first.weight / 2);
+        if (target > total_weight_ - last.weight / 2)
+            return last.mean + (max_ - last.mean) * (target - (total_weight_ - last.weight / 2)) /
+                                   (last.weight / 2);
+
+        // interpolate between the centers of the two centroids around the target
+        double cumulative = 0;
+        for (size_t i = 0; i + 1 < centroids_.size(); ++i)
+        {
+            const double left = cumulative + centroids_[i].weight / 2;
+            const double right = cumulative + centroids_[i].weight + centroids_[i + 1].weight / 2;
+            if (target <= right)
+                return centroids_[i].mean + (centroids_[i + 1].mean - centroids_[i].mean) *
+                                                (target - left) / (right - left);
+            cumulative += centroids_[i].weight;
+        }
+        return last.mean;
+    }
+
+    double total_weight() const
+    {
+        compress();
+        return total_weight_;
+    }
+
+    const std::vector<Centroid> &centroids() const
+    {
+        compress();
+        return centroids_;
+    }
+
+    void save_binary(std::ostream &stream) const
+    {
+        compress();
+        binary::write(stream, compression_);
+        binary::write(stream, min_);
+        binary::write(stream, max_);
+        binary::write_vector(stream, centroids_);
+    }
+
+    void load_binary(std::istream &stream)
+    {
+        compression_ = binary::read<double>(stream);
+        min_ = binary::read<double>(stream);
+        max_ = binary::read<double>(stream);
+        centroids_ = binary::read_vector<Centroid>(stream);
+        buffer_.clear();
+        total_weight_ = 0;
+        for (auto &&centroid : centroids_)
+            total_weight_ += centroid.weight;
+    }
+
+protected:
+    size_t buffer_limit() const
+    {
+        return static_cast<size_t>(5 * compression_) + 1;
+    }
+
+    // the k1 scale function, which keeps centroids small near the tails
+    inline double scale(double q) const
+    {
+        return compression_ / (2 * pi) * std::asin(2 * std::min(q, 1.) - 1);
+    }
+
+    // merging is deferred until a read, hence the mutable state behind a const interface
+    void compress() const
+    {
+        if (buffer_.empty())
+            return;
+        buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+        std::sort(
+            buffer_.begin(), buffer_.end(),
+            [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; }
+        );
+        total_weight_ = 0;
+        for (auto &&centroid : buffer_)
+            total_weight_ += centroid.weight;
+
+        centroids_.clear();
+        Centroid current = buffer_[0];
+        double weight_so_far = 0;
+        for (size_t i = 1; i < buffer_.size(); ++i)
+        {
+            const Centroid &next = buffer_[i];
+            const double q_left = weight_so_far / total_weight_;
+            const double q_right = (weight_so_far + current.weight + next.weight) / total_weight_;
+            if (scale(q_right) - scale(q_left) <= 1)
+            {
+                current.weight += next.weight;
+                current.mean += (next.mean - current.mean) * next.weight / current.weight;
+            }
+            else
+            {
+                weight_so_far += current.weight;
+                centroids_.push_back(current);
+                current = next;
+            }
+        }
+        centroids_.push_back(current);
+        buffer_.clear();
+    }
+
+    static constexpr double pi = 3.14159265358979323846;
+
+    double compression_;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = std::numeric_limits<double>::lowest();
+    mutable double total_weight_ = 0;
+    mutable std::vector<Centroid> centroids_;
+    mutable std::vector<Centroid> buffer_;
+};
+
+/*
+ * A uniform random sample of at most `capacity` of all values added (Vitter's algorithm R).
+ * Merging two samples keeps each value with a probability proportional to how many values it
+ * stands for.
+ */
+class ReservoirSample
+{
+public:
+    explicit ReservoirSample(size_t capacity = 0, uint32_t seed = 1)
+      : capacity_(capacity), rng_(seed)
+    {
+        samples_.reserve(capacity);
+    }
+
+    inline void add(double value)
+    {
+        ++seen_;
+        if (samples_.size() < capacity_)
+            samples_.push_back(value);
+        else if (capacity_ > 0)
+        {
+            const uint64_t index = std::uniform_int_distribution<uint64_t>(0, seen_ - 1)(rng_);
+            if (index < capacity_)
+                samples_[index] = value;
+        }
+    }
+
+    void merge(const ReservoirSample &other)
+    {
+        if (other.seen_ == 0)
+            return;
+        std::vector<double> mine = samples_, theirs = other.samples_;
+        std::shuffle(mine.begin(), mine.end(), rng_);
+        std::shuffle(theirs.begin(), theirs.end(), rng_);
+        // the number of values each remaining sample stands for
+        double mine_weight = mine.empty() ? 0 : static_cast<double>(seen_);
+        double theirs_weight = theirs.empty() ? 0 : static_cast<double>(other.seen_);
+        const double mine_each = mine.empty() ? 0 : mine_weight / mine.size();
+        const double theirs_each = theirs.empty() ? 0 : theirs_weight / theirs.size();
+
+        samples_.clear();
+        std::uniform_real_distribution<double> uniform;
+        while (samples_.size() < capacity_ && (!mine.empty() || !theirs.empty()))
+        {
+            const bool take_mine =
+                theirs.empty() ||
+                (!mine.empty() && uniform(rng_) * (mine_weight + theirs_weight) < mine_weight);
+            auto &source = take_mine ? mine : theirs;
+            samples_.push_back(source.back());
+            source.pop_back();
+            (take_mine ? mine_weight : theirs_weight) -= take_mine ? mine_each : theirs_each;
+        }
+        seen_ += other.seen_;
+    }
+
+    const std::vector<double> &samples() const
+    {
+        return samples_;
+    }
+
+    uint64_t seen() const
+    {
+        return seen_;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // the state of the random engine is not saved, only the sample
+    void save_binary(std::ostream &stream) const
+    {
+        binary::write<uint64_t>(stream, capacity_);
+        binary::write(stream, seen_);
+        binary::write_vector(stream, samples_);
+    }
+
+    void load_binary(std::istream &stream)
+    {
+        capacity_ = binary::read<uint64_t>(stream);
+        seen_ = binary::read<uint64_t>(stream);
+        samples_ = binary::read_vector<double>(stream);
+    }
+
+protected:
+    size_t capacity_;
+    uint64_t seen_ = 0;
+    std::vector<double> samples_;
+    std::minstd_rand rng_;
+};
+
+/*
+ * A fixed-size summary of a stream of values: exact count, min, max and (Welford) moments, a
+ * t-digest for quantiles, and optionally a reservoir sample of the values themselves.
+ */
+class StreamingSummary
+{
+public:
+    explicit StreamingSummary(size_t reservoir_size = 0, double compression = 100)
+      : digest_(compression), reservoir_(reservoir_size)
+    {
+    }
+
+    inline void add(double value)
+    {
+        ++count_;
+        const double delta = value - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (value - mean_);
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        digest_.add(value);
+        reservoir_.add(value);
+    }
+
+    void merge(const StreamingSummary &other)
+    {
+        if (other.count_ == 0)
+            return;
+        const double total = static_cast<double>(count_ + other.count_);
+        const double delta = other.mean_ - mean_;
+        mean_ += delta * other.count_ / total;
+        m2_ += other.m2_ + delta * delta * count_ * other.count_ / total;
+        count_ += other.count_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        digest_.merge(other.digest_);
+        reservoir_.merge(other.reservoir_);
+    }
+
+    uint64_t count() const
+    {
+        return count_;
+    }
+
+    double mean() const
+    {
+        return count_ ? mean_ : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double variance() const
+    {
+        if (count_ < 2)
+            return count_ == 1 ? 0 : std::numeric_limits<double>::quiet_NaN();
+        return m2_ / (count_ - 1);
+    }
+
+    double stdev() const
+    {
+        return std::sqrt(variance());
+    }
+
+    double min() const
+    {
+        return min_;
+    }
+
+    double max() const
+    {
+        return max_;
+    }
+
+    double quantile(double q) const
+    {
+        return digest_.quantile(q);
+    }
+
+    const TDigest &digest() const
+    {
+        return digest_;
+    }
+
+    const ReservoirSample &reservoir() const
+    {
+        return reservoir_;
+    }
+
+    void save_binary(std::ostream &stream) const
+    {
+        binary::write(stream, count_);
+        binary::write(stream, mean_);
+        binary::write(stream, m2_);
+        binary::write(stream, min_);
+        binary::write(stream, max_);
+        digest_.save_binary(stream);
+        reservoir_.save_binary(stream);
+    }
+
+    void load_binary(std::istream &stream)
+    {
+        count_ = binary::read<uint64_t>(stream);
+        mean_ = binary::read<double>(stream);
+        m2_ = binary::read<double>(stream);
+        min_ = binary::read<double>(stream);
+        max_ = binary::read<double>(stream);
+        digest_.load_binary(stream);
+        reservoir_.load_binary(stream);
+    }
+
+    /*
+     * Values that stand for the distribution, e.g. for a box plot: the reservoir sample if any,
+     * otherwise every percentile of the digest.
+     */
+    std::vector<double> representative_values() const
+    {
+        if (!reservoir_.samples().empty())
+            return reservoir_.samples();
+        std::vector<double> values;
+        if (count_ == 0)
+            return values;
+        for (int percentile = 0; percentile <= 100; ++percentile)
+            values.push_back(quantile(percentile / 100.));
+        return values;
+    }
+
+    operator std::string() const
+    {
+        std::stringstream ss;
+        ss << "{n=" << count_ << ", mean=" << mean() << ", stdev=" << stdev() << ", min=" << min_
+           << ", p25=" << quantile(.25) << ", p50=" << quantile(.5) << ", p75=" << quantile(.75)
+           << ", max=" << max_ << "}";
+        return ss.str();
+    }
+
+protected:
+    uint64_t count_ = 0;
+    double mean_ = 0;
+    double m2_ = 0;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = std::numeric_limits<double>::lowest();
+    TDigest digest_;
+    ReservoirSample reservoir_;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+namespace __sxs_summary
+{
+
+TEST_CASE("[sxs] Streaming summaries")
+{
+    sxs::StreamingSummary summary(100), first_half(100), second_half(100);
+    std::minstd_rand rng(42);
+    std::normal_distribution<double> normal(5, 2);
+    for (int i = 0; i < 100000; ++i)
+    {
+        const double value = normal(rng);
+        summary.add(value);
+        (i % 2 ? first_half : second_half).add(value);
+    }
+
+    CHECK(summary.count() == 100000);
+    CHECK(summary.mean() == doctest::Approx(5).epsilon(0.01));
+    CHECK(summary.stdev() == doctest::Approx(2).epsilon(0.01));
+    // within 1% of the normal quantiles
+    CHECK(summary.quantile(0.5) == doctest::Approx(5).epsilon(0.01));
+    CHECK(summary.quantile(0.975) == doctest::Approx(5 + 1.96 * 2).epsilon(0.01));
+    CHECK(summary.quantile(0.025) == doctest::Approx(5 - 1.96 * 2).epsilon(0.02));
+    CHECK(summary.quantile(0) == summary.min());
+    CHECK(summary.quantile(1) == summary.max());
+    // bounded memory
+    CHECK(summary.digest().centroids().size() < 200);
+    CHECK(summary.reservoir().samples().size() == 100);
+
+    SUBCASE("merged summaries equal a single one")
+    {
+        first_half.merge(second_half);
+        CHECK(first_half.count() == summary.count());
+        CHECK(first_half.mean() == doctest::Approx(summary.mean()));
+        CHECK(first_half.stdev() == doctest::Approx(summary.stdev()));
+        CHECK(first_half.quantile(0.9) == doctest::Approx(summary.quantile(0.9)).epsilon(0.01));
+        CHECK(first_half.reservoir().samples().size() == 100);
+        CHECK(first_half.reservoir().seen() == 100000);
+    }
+
+    SUBCASE("representative values")
+    {
+        sxs::StreamingSummary without_reservoir;
+        for (int i = 0; i <= 1000; ++i)
+            without_reservoir.add(i);
+        const auto values = without_reservoir.representative_values();
+        REQUIRE(values.size() == 101);
+        CHECK(values[50] == doctest::Approx(500).epsilon(0.01));
+        CHECK(summary.representative_values().size() == 100);
+    }
+
+    SUBCASE("binary round trip")
+    {
+        std::stringstream stream;
+        summary.save_binary(stream);
+        sxs::StreamingSummary loaded;
+        loaded.load_binary(stream);
+        CHECK(loaded.count() == summary.count());
+        CHECK(loaded.mean() == summary.mean());
+        CHECK(loaded.stdev() == summary.stdev());
+        CHECK(loaded.quantile(0.9) == summary.quantile(0.9));
+        CHECK(loaded.reservoir().samples() == summary.reservoir().samples());
+        CHECK_THROWS_AS(loaded.load_binary(stream), const std::runtime_error &);
+    }
+}
+
+}  // namespace __sxs_summary
+#endif  // SXS_RUN_TESTS
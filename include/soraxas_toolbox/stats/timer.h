@@ -27,13 +27,27 @@
 
 #pragma once
 
+#include "alloc_counter.h"
+#include "interned_string.h"
+#include "perf_counters.h"
 #include "timer_interface.h"
 #include "timing.h"
 
 #include "../clock.h"
 #include "../external/ordered-map/ordered_map.h"
+#include "../parallel.h"
 #include "../print_utils_core.h"
 
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
 namespace sxs
 {
 
@@ -42,7 +56,11 @@ struct pair_hash
     template <class T1, class T2>
     std::size_t operator()(const std::pair<T1, T2> &pair) const
     {
-        return std::hash<T1>()(pair.first) ^ std::hash<T2>()(pair.second);
+        // combine as in boost::hash_combine, as a plain xor collides (a,b) with (b,a), and maps all
+        // (a,a) to zero
+        std::size_t seed = std::hash<T1>()(pair.first);
+        seed ^= std::hash<T2>()(pair.second) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+        return seed;
     }
 };
 
@@ -58,13 +76,94 @@ template <typename Token>
 using TimeStampCollection =
     tsl::ordered_map<TimeStampCollectionKey<Token>, Stats<double>, pair_hash>;
 
+/*
+ * Whether compile_result records a histogram for percentiles by default, which costs a fixed
+ * amount of memory per token pair.
+ */
+inline bool &compile_with_percentiles()
+{
+    static bool with_percentiles = false;
+    return with_percentiles;
+}
+
+/*
+ * Add an item of the stamped iterator into its stats, with its weight if the item has one.
+ */
+template <typename ResultDataType, typename Item>
+inline void add_stamped_item(Stats<ResultDataType> &stat, const Item &item)
+{
+    if constexpr (std::tuple_size<std::decay_t<Item>>::value > 3)
+        stat.add(std::get<2>(item), std::get<3>(item));
+    else
+        stat.add(std::get<2>(item));
+}
+
+#ifdef SXS_HAS_ENUM_HPP
+/*
+ * Compile results of enum.hpp tokens into a flat N x N table indexed by the tokens, which avoids
+ * hashing every sample. Only the token pairs that appeared are then moved into the
+ * TimeStampCollection, in the order they first appeared.
+ */
+template <typename ResultDataType, typename Token, typename IteratorContainer>
+TimeStampCollection<Token>
+compile_result_dense(IteratorContainer &container, bool with_percentiles)
+{
+    constexpr size_t num_tokens = enum_hpp::size<Token>();
+
+    std::vector<Stats<ResultDataType>> table(num_tokens * num_tokens);
+    std::vector<size_t> first_seen;
+    // tokens that are not registered (e.g. casted from integers) fall back to hashing
+    tsl::ordered_map<std::pair<Token, Token>, Stats<ResultDataType>, pair_hash> unregistered{};
+
+    for (auto &&item : container)
+    {
+        const auto token_from = (Token)std::get<0>(item);
+        const auto token_to = (Token)std::get<1>(item);
+        const size_t index_from = sxs::stats::get_token_index(token_from);
+        const size_t index_to = sxs::stats::get_token_index(token_to);
+
+        Stats<ResultDataType> *stat;
+        if (index_from < num_tokens && index_to < num_tokens)
+        {
+            const size_t index = index_from * num_tokens + index_to;
+            stat = &table[index];
+            if (stat->count == 0)
+                first_seen.push_back(index);
+        }
+        else
+            stat = &unregistered[std::make_pair(token_from, token_to)];
+
+        if (with_percentiles && stat->count == 0)
+            stat->enable_histogram();
+        add_stamped_item(*stat, item);
+    }
+
+    TimeStampCollection<Token> result{};
+    result.reserve(first_seen.size() + unregistered.size());
+    for (auto &&index : first_seen)
+    {
+        result.emplace(
+            std::make_pair(
+                sxs::stats::get_token_from_index<Token>(index / num_tokens),
+                sxs::stats::get_token_from_index<Token>(index % num_tokens)
+            ),
+            std::move(table[index])
+        );
+    }
+    for (auto &&item : unregistered)
+        result.emplace(item.first, item.second);
+    return result;
+}
+#endif  // SXS_HAS_ENUM_HPP
+
 /*
  * Compile results from interator that returns <token_e1, token_e2, double>
  * */
 template <
     typename ResultDataType = double, typename IteratorContainer,
     typename Token = typename std::tuple_element<0, typename IteratorContainer::stat_t>::type>
-TimeStampCollection<Token> compile_result(IteratorContainer &container)
+TimeStampCollection<Token>
+compile_result(IteratorContainer &container, bool with_percentiles = compile_with_percentiles())
 {
     static_assert(
         std::is_same<
@@ -73,43 +172,58 @@ TimeStampCollection<Token> compile_result(IteratorContainer &container)
         "Inconsistent token type for tuple element 1 & 2"
     );
 
-    tsl::ordered_map<std::pair<Token, Token>, Stats<ResultDataType>, pair_hash> result{};
+#ifdef SXS_HAS_ENUM_HPP
+    if constexpr (sxs::stats::is_enum_hpp_token<Token>())
+        return compile_result_dense<ResultDataType, Token>(container, with_percentiles);
+#endif
 
-    tsl::ordered_map<std::pair<Token, Token>, std::vector<double>, pair_hash> tmp_result{};
+    tsl::ordered_map<std::pair<Token, Token>, Stats<ResultDataType>, pair_hash> result{};
 
     for (auto &&item : container)
     {
         auto key =
             std::make_pair<Token, Token>(((Token)std::get<0>(item)), ((Token)std::get<1>(item)));
         auto &stat = result[key];
-
-        const double val = std::get<2>(item);
-        //                    stat.count++;
-        stat.min = std::min(val, stat.min);
-        stat.max = std::max(val, stat.max);
-        stat.sum += val;
-        tmp_result[key].push_back(val);
+        if (with_percentiles && stat.count == 0)
+            stat.enable_histogram();
+        add_stamped_item(stat, item);
     }
 
-    for (auto &&tmp_item : tmp_result)
+    return result;
+}
+
+/*
+ * Format the percentiles columns, if the stats has recorded a histogram.
+ */
+template <typename DataType>
+inline std::string format_percentiles(const Stats<DataType> &stats)
+{
+    if (!stats.histogram)
+        return "";
+    std::stringstream ss;
+    ss << " {";
+    bool firstitem = true;
+    for (double percentile : {50., 90., 99., 99.9})
     {
-        auto &stat = result[tmp_item.first];
-        auto &tmp_collected_vals = tmp_item.second;
-        stat.count = tmp_collected_vals.size();
-        stat.mean() = stat.sum / stat.count;
-        stat.stdev() = sxs::compute_stdev(stat.mean(), tmp_collected_vals);
+        if (firstitem)
+            firstitem = false;
+        else
+            ss << "|";
+        ss << "p" << percentile << " " << format_time2readable(stats.percentile(percentile));
     }
-
-    //                result[{std::get<0>(stat),
-    //                std::get<1>(stat)}].push_back(std::get<2>(stat));
-
-    return result;
+    ss << "}";
+    return ss.str();
 }
 
+/*
+ * Token pairs whose mean is at most noise_floor are flagged as within measurement noise.
+ * extra_columns, if given, formats more columns of a token pair (e.g. perf counters).
+ */
 template <typename Token>
 void print_compiled_stats(
     const TimeStampCollection<Token> &stamped,
-    const std::function<std::string(Token)> &to_string_functor = 0
+    const std::function<std::string(Token)> &to_string_functor = 0, double noise_floor = 0,
+    const std::function<std::string(const TimeStampCollectionKey<Token> &)> &extra_columns = 0
 )
 {
     using sxs::format_time2readable;
@@ -155,13 +269,16 @@ void print_compiled_stats(
             << std::setw(string_1_max_len) << token_to_str[token_from]  // from
             << " -> "                                                   //
             << std::setw(string_2_max_len) << token_to_str[token_to]    // to
-            << ": " << format_time2readable(item.second.mean_stdev)     // mean, stdev
+            << ": " << format_time2readable(item.second.mean_stdev())   // mean, stdev
             << " (" << format_time2readable(item.second.min) << "~"     // min
             << format_time2readable(item.second.max) << ")"             // max
+            << format_percentiles(item.second)                          // p50, p90, ...
             << " [Σ^" << std::setw(stats_size_max_len)
             << item.second.count  // number of collected stats size
             << "=" << format_time2readable(item.second.sum) << "|"  // sum
             << _FIX_WIDTH_DECIMAL(3) << (item.second.sum / total_time_spent * 100) << "%]"
+            << (extra_columns ? extra_columns(item.first) : "")  // extra columns
+            << (item.second.mean() <= noise_floor ? " (within measurement noise)" : "")
             << std::endl;  // percentage of time spent
     }
     sxs::println("====================================");
@@ -180,6 +297,45 @@ inline void print_compiled_stats(const TimeStampCollection<Token> &stamped, F to
     print_compiled_stats(stamped, functor);
 }
 
+/*
+ * Merge the stats of one compiled result into another. Merging the moments gives the mean and stdev
+ * over all samples of both, and token pairs new to `into` are appended in their order in `from`.
+ */
+template <typename Token>
+inline void
+merge_compiled_stats(TimeStampCollection<Token> &into, const TimeStampCollection<Token> &from)
+{
+    for (auto &&item : from)
+        into[item.first].accumulate_standard(item.second);
+}
+
+/*
+ * Compile and merge many stampers, e.g., one per episode. Contiguous blocks of stampers are
+ * compiled concurrently, and the partial results are then merged pairwise in a tree, such that the
+ * result (including its order) is the same as compiling and merging them one after another.
+ */
+template <
+    typename CompilableTimeStamper,
+    typename Token = typename std::tuple_element<0, typename CompilableTimeStamper::stat_t>::type>
+TimeStampCollection<Token> compile_aggregated(
+    const std::vector<CompilableTimeStamper> &time_stampers,
+    size_t num_workers = std::max(1u, std::thread::hardware_concurrency())
+)
+{
+    return parallel_block_reduce(
+        time_stampers.size(), num_workers,
+        [&time_stampers](size_t first, size_t last)
+        {
+            TimeStampCollection<Token> partial{};
+            for (size_t i = first; i < last; ++i)
+                merge_compiled_stats(partial, sxs::compile_result(time_stampers[i]));
+            return partial;
+        },
+        [](TimeStampCollection<Token> &into, const TimeStampCollection<Token> &from)
+        { merge_compiled_stats(into, from); }
+    );
+}
+
 template <typename Token, typename F>
 void print_aggregated_stamped_stats(
     const std::vector<TimeStampCollection<Token>> &all_stamped, F to_string_functor
@@ -187,26 +343,8 @@ void print_aggregated_stamped_stats(
 {
     TimeStampCollection<Token> aggregated_stamped{};
 
-    tsl::ordered_map<TimeStampCollectionKey<Token>, std::vector<double>, pair_hash>
-        aggregated_stamped_tmp;
-
     for (auto &&stamped : all_stamped)
-    {
-        for (auto &&item : stamped)
-        {
-            aggregated_stamped[item.first].accumulate_without_mean_stdev(item.second);
-            aggregated_stamped_tmp[item.first].push_back(item.second.mean());
-        }
-    }
-    // second pass to compute mean and stdev
-
-    for (auto &&stamped : aggregated_stamped)
-    {
-        auto &&item = aggregated_stamped[stamped.first];
-        item.mean() = stamped.second.sum / stamped.second.count;
-        item.stdev() =
-            sxs::compute_stdev(stamped.second.mean(), aggregated_stamped_tmp[stamped.first]);
-    }
+        merge_compiled_stats(aggregated_stamped, stamped);
     print_compiled_stats(aggregated_stamped, to_string_functor);
 }
 
@@ -231,32 +369,55 @@ void print_aggregated_stamped_stats(
     const std::vector<CompilableTimeStamper> &time_stameprs, Args... args
 )
 {
-    std::vector<TimeStampCollection<Token>> all_stamped;
-    all_stamped.reserve(time_stameprs.size());
-    bool valid = true;
     for (auto &&time_stamper : time_stameprs)
     {
-        if (valid)
-            // once something reported invalid, stop checking to avoid being over-flooded with
-            // messages
-            valid &= time_stamper.check_validity();
-        all_stamped.push_back(sxs::compile_result(time_stamper));
+        // once something reported invalid, stop checking to avoid being over-flooded with
+        // messages
+        if (!time_stamper.check_validity())
+            break;
     }
-    print_aggregated_stamped_stats(all_stamped, std::forward<Args>(args)...);
+    const auto aggregated_stamped = compile_aggregated(time_stameprs);
+    if constexpr (sizeof...(Args) == 0)
+        print_compiled_stats(aggregated_stamped);
+    else
+        print_compiled_stats(aggregated_stamped, std::forward<Args>(args)...);
 }
 }  // namespace sxs
 
 namespace sxs
 {
 
-template <typename Token>
-class TimeStamperBase : public Timer
+template <typename ClockPolicy>
+const MeasurementOverhead &stamp_overhead();
+
+template <typename Token, typename ClockPolicy = clock_policy::default_clock>
+class TimeStamperBase : public TimerBase<ClockPolicy>
 {
 protected:
-    using Timer::clock_;
+    using clock_ = ClockPolicy;
+    using TimerBase<ClockPolicy>::timepoint_diff_to_secs;
+    // stamped intervals (with their start) are kept in raw clock ticks, and only converted when
+    // reporting
+    using stamped_t =
+        std::tuple<Token, Token, typename clock_::time_point, typename clock_::duration>;
 
 public:
-    using stat_t = TimeStamperStatIteratorReturnType<Token>;
+    using stat_t = TimeStamperWeightedStatIteratorReturnType<Token>;
+    using clock_policy_t = ClockPolicy;
+
+    /*
+     * How intervals are selected when sampling:
+     *  - every_nth records 1 in N intervals. When the stamps of a loop repeat with a period that
+     *    shares a factor with N, the same token pairs get picked every time, so prefer random.
+     *  - random records each interval with a probability of 1 / N.
+     */
+    enum class sampling_mode
+    {
+        none,
+        every_nth,
+        random,
+    };
+    using TimerBase<ClockPolicy>::elapsed;
 
     TimeStamperBase(
         const std::string &name = "", bool print_starter = false, bool auto_print = true
@@ -276,17 +437,133 @@ public:
         finish();
     }
 
+    /*
+     * Number of recorded intervals, which is less than num_intervals() when sampling.
+     */
     size_t count()
     {
         return stamped.size();
     }
 
+    /*
+     * Number of stamped intervals, recorded or not.
+     */
+    size_t num_intervals() const
+    {
+        return m_num_intervals;
+    }
+
     void reset()
     {
         stamped.clear();
+        m_weights.clear();
+        m_counter_totals.clear();
+        m_alloc_totals.clear();
+        m_num_intervals = 0;
         _last_stamped_token = Token{};
     }
 
+    /*
+     * Only record a subset of intervals, such that stamping in tight loops costs a fraction of
+     * the work being measured. Each recorded interval is weighted by the inverse of its sampling
+     * probability, hence compiled counts and sums estimate those of all intervals.
+     *
+     * With an overhead budget (e.g. 0.01 for 1% of the stamped time), N starts at the given value
+     * and is then adapted to the measured cost of a recorded stamp relative to the mean interval.
+     * The cost of skipped stamps (a counter decrement) is not accounted for.
+     */
+    void set_sampling(sampling_mode mode, size_t sample_every = 1, double overhead_budget = 0)
+    {
+        m_sampling = mode;
+        m_sample_every = std::max<size_t>(sample_every, 1);
+        m_overhead_budget = overhead_budget;
+        m_num_skip = 0;
+        m_adapt_overhead = {};
+        m_adapt_sampled = {};
+        m_adapt_num_sampled = 0;
+        // intervals recorded so far stand for themselves. Weights are either empty, or one per
+        // recorded interval once sampling was ever enabled.
+        if (mode != sampling_mode::none)
+            m_weights.resize(stamped.size(), 1);
+    }
+
+    /*
+     * Subtract the overhead of an empty stamp-to-stamp interval (see stamp_overhead()) from every
+     * reported interval. Follows subtract_measurement_overhead() unless set.
+     */
+    void set_subtract_overhead(bool subtract = true)
+    {
+        m_subtract_overhead = subtract;
+    }
+
+    bool is_subtracting_overhead() const
+    {
+        return m_subtract_overhead.value_or(subtract_measurement_overhead());
+    }
+
+    /*
+     * Also read perf_event counters (see PerfCounterSet) at every recorded stamp, and report their
+     * mean delta per token pair next to the timings. Counters are those of the calling thread,
+     * which should be the stamping thread. Each stamp then costs a syscall, which the counters
+     * (but not the timings) include.
+     *
+     * Returns false if no counter is available.
+     */
+    bool enable_counters()
+    {
+        m_counters = std::make_shared<PerfCounterSet>();
+        if (!m_counters->available())
+        {
+            m_counters.reset();
+            return false;
+        }
+        m_counters->read(m_last_counter_values);
+        return true;
+    }
+
+    /*
+     * Counter deltas summed per token pair, since counters were enabled (or the last reset).
+     */
+    const std::unordered_map<TimeStampCollectionKey<Token>, PerfCounterTotals, pair_hash> &
+    counter_totals() const
+    {
+        return m_counter_totals;
+    }
+
+    std::shared_ptr<const PerfCounterSet> counters() const
+    {
+        return m_counters;
+    }
+
+    /*
+     * Also report the mean heap allocations (count and bytes) per token pair, as counted by the
+     * allocation hook (see AllocCounts) for the stamping thread. Returns false, and reports
+     * nothing, if the hook is not installed.
+     */
+    bool enable_alloc_counts(bool enable = true)
+    {
+        m_count_allocations = enable && alloc_hook_installed;
+        m_last_alloc_counts = thread_alloc_counts();
+        return m_count_allocations;
+    }
+
+    /*
+     * Allocation deltas summed per token pair, since they were enabled (or the last reset).
+     */
+    const std::unordered_map<TimeStampCollectionKey<Token>, AllocTotals, pair_hash> &
+    alloc_totals() const
+    {
+        return m_alloc_totals;
+    }
+
+    /*
+     * The current N of sampling 1 in N intervals.
+     */
+    size_t sample_every() const
+    {
+        return m_sample_every;
+    }
+
     void finish()
     {
         if (m_finished)
@@ -306,7 +583,34 @@ public:
 
     void print_stamped_stats()
     {
-        print_compiled_stats(compile_result(*this));
+        const MeasurementOverhead &overhead = stamp_overhead<ClockPolicy>();
+        std::function<std::string(const TimeStampCollectionKey<Token> &)> counter_columns;
+        if (m_counters || m_count_allocations)
+        {
+            counter_columns = [this](const TimeStampCollectionKey<Token> &key)
+            {
+                std::string columns;
+                auto totals = m_counter_totals.find(key);
+                if (m_counters && totals != m_counter_totals.end())
+                    columns += m_counters->format(totals->second.sums, totals->second.count);
+                auto allocations = m_alloc_totals.find(key);
+                if (allocations != m_alloc_totals.end())
+                    columns += allocations->second.format();
+                return columns;
+            };
+        }
+        print_compiled_stats(
+            compile_result(*this), {},
+            overhead.noise_floor - (is_subtracting_overhead() ? overhead.overhead : 0),
+            counter_columns
+        );
+        if (m_sampling != sampling_mode::none)
+        {
+            sxs::println(
+                "[", name, "] recorded ", stamped.size(), " of ", m_num_intervals,
+                " intervals (currently 1 in ", m_sample_every, ")"
+            );
+        }
     }
 
     operator std::string() const
@@ -351,8 +655,10 @@ public:
 
     class iterator
     {
-        const std::vector<TimeStamperStatIteratorReturnType<Token>> &stamped_ref_;
+        const std::vector<stamped_t> &stamped_ref_;
+        const std::vector<uint32_t> &weights_ref_;
         long num;
+        double offset_;
 
     public:
         using iterator_category = std::output_iterator_tag;
@@ -362,9 +668,10 @@ public:
         using reference = stat_t;
 
         explicit iterator(
-            const std::vector<TimeStamperStatIteratorReturnType<Token>> &ref, long _num
+            const std::vector<stamped_t> &ref, const std::vector<uint32_t> &weights, long _num,
+            double offset = 0
         )
-          : stamped_ref_(ref), num(_num)
+          : stamped_ref_(ref), weights_ref_(weights), num(_num), offset_(offset)
         {
         }
 
@@ -393,18 +700,27 @@ public:
 
         stat_t operator*() const
         {
-            return stamped_ref_[num];
+            const stamped_t &item = stamped_ref_[num];
+            return stat_t{
+                std::get<0>(item), std::get<1>(item),
+                offset_ > 0 ? std::max(timepoint_diff_to_secs(std::get<3>(item)) - offset_, 0.)
+                            : timepoint_diff_to_secs(std::get<3>(item)),
+                weights_ref_.empty() ? 1 : weights_ref_[num]
+            };
         }
     };
 
     iterator begin() const
     {
-        return iterator(stamped, 0);
+        return iterator(
+            stamped, m_weights, 0,
+            is_subtracting_overhead() ? stamp_overhead<ClockPolicy>().overhead : 0
+        );
     }
 
     iterator end() const
     {
-        return iterator(stamped, stamped.size());
+        return iterator(stamped, m_weights, stamped.size());
     }
 
     bool check_validity() const
@@ -412,39 +728,278 @@ public:
         return true;
     }
 
+    /*
+     * Recorded intervals that were taken out of a stamper, which can be compiled like a stamper.
+     */
+    class Snapshot
+    {
+    public:
+        using stat_t = typename TimeStamperBase::stat_t;
+
+        iterator begin() const
+        {
+            return iterator(stamped_, weights_, 0, offset_);
+        }
+
+        iterator end() const
+        {
+            return iterator(stamped_, weights_, stamped_.size());
+        }
+
+        bool check_validity() const
+        {
+            return true;
+        }
+
+        size_t count() const
+        {
+            return stamped_.size();
+        }
+
+        // empty, but keep the buffers for the next take_snapshot(Snapshot &)
+        void clear()
+        {
+            stamped_.clear();
+            weights_.clear();
+        }
+
+    private:
+        friend class TimeStamperBase;
+        std::vector<stamped_t> stamped_;
+        std::vector<uint32_t> weights_;
+        double offset_ = 0;
+    };
+
+    /*
+     * Take out all recorded intervals, while keeping the interval in progress, such that stamping
+     * continues seamlessly into the next snapshot.
+     */
+    Snapshot take_snapshot()
+    {
+        Snapshot snapshot;
+        prepare_snapshot(snapshot);
+        take_snapshot(snapshot);
+        if (m_sampling != sampling_mode::none)
+            m_weights.reserve(snapshot.weights_.capacity());
+        stamped.reserve(snapshot.stamped_.capacity());
+        return snapshot;
+    }
+
+    /*
+     * Empty a (previous) snapshot, and calibrate the overhead to subtract if it is the first use.
+     * To be called before take_snapshot(Snapshot &), e.g. outside of a lock shared with stamping.
+     */
+    void prepare_snapshot(Snapshot &snapshot) const
+    {
+        snapshot.clear();
+        snapshot.offset_ = is_subtracting_overhead() ? stamp_overhead<ClockPolicy>().overhead : 0;
+    }
+
+    /*
+     * Swap all recorded intervals into a prepared snapshot, whose buffers (with their capacity)
+     * take their place. Only swaps vectors, hence never allocates.
+     */
+    void take_snapshot(Snapshot &snapshot)
+    {
+        snapshot.stamped_.swap(stamped);
+        snapshot.weights_.swap(m_weights);
+        m_num_intervals = 0;
+    }
+
+    /*
+     * Compiled stats of the intervals since the last snapshot.
+     */
+    TimeStampCollection<Token> snapshot_and_reset()
+    {
+        const Snapshot snapshot = take_snapshot();
+        return compile_result(snapshot);
+    }
+
+    /*
+     * Visit each stamped interval as (token_from, token_to, start time_point, duration), e.g., to
+     * place them on a timeline.
+     */
+    template <typename F>
+    void for_each_interval(const F &functor) const
+    {
+        for (auto &&item : stamped)
+            functor(std::get<0>(item), std::get<1>(item), std::get<2>(item), std::get<3>(item));
+    }
+
 protected:
-    std::vector<TimeStamperStatIteratorReturnType<Token>> stamped;
+    /*
+     * Record the interval since the last stamp (if there is one), and start the next interval.
+     */
+    template <typename T>
+    inline void stamp_interval(T &&token, bool has_last)
+    {
+        const bool was_sampled = m_last_sampled;
+        // taken first, such that the stamper's own allocations below are never attributed
+        AllocCounts allocations;
+        if (m_count_allocations && was_sampled)
+            allocations = thread_alloc_counts();
+        if (m_last_sampled)
+        {
+            const auto now = clock_::now();
+            if (has_last)
+            {
+                stamped.emplace_back(
+                    _last_stamped_token, token, _last_stamped_clock, now - _last_stamped_clock
+                );
+                if (m_sampling != sampling_mode::none)
+                    on_recorded_interval(now);
+                else if (!m_weights.empty())
+                    m_weights.push_back(m_next_weight);
+            }
+        }
+        if (has_last)
+            ++m_num_intervals;
+        // an interval skipped before sampling was turned off stays skipped, as it was never timed
+        m_last_sampled = m_sampling == sampling_mode::none || sample_next_interval();
+        if (m_sampling == sampling_mode::none)
+            m_next_weight = 1;
+        if (m_count_allocations && has_last && was_sampled)
+            m_alloc_totals[std::make_pair(_last_stamped_token, token)].add(
+                m_last_alloc_counts, allocations
+            );
+        if (m_counters && (was_sampled || m_last_sampled))
+            read_counters(token, has_last && was_sampled);
+        if (m_count_allocations && m_last_sampled)
+            m_last_alloc_counts = thread_alloc_counts();
+        if (m_last_sampled)
+            _last_stamped_clock = clock_::now();
+        _last_stamped_token = std::forward<T>(token);
+    }
+
+    void read_counters(const Token &token, bool ends_recorded_interval)
+    {
+        PerfCounterSet::Values values;
+        m_counters->read(values);
+        if (ends_recorded_interval)
+            m_counter_totals[std::make_pair(_last_stamped_token, token)].add(
+                m_last_counter_values, values
+            );
+        m_last_counter_values = values;
+    }
+
+    inline bool sample_next_interval()
+    {
+        if (m_num_skip > 0)
+        {
+            --m_num_skip;
+            return false;
+        }
+        if (m_sampling == sampling_mode::every_nth)
+            m_num_skip = m_sample_every - 1;
+        else if (m_sample_every > 1)
+        {
+            // the number of failures before a success is geometric
+            const double u = std::uniform_real_distribution<double>(
+                std::numeric_limits<double>::min(), 1.
+            )(m_rng);
+            m_num_skip = static_cast<size_t>(
+                std::log(u) / std::log1p(-1. / static_cast<double>(m_sample_every))
+            );
+        }
+        m_next_weight = static_cast<uint32_t>(m_sample_every);
+        return true;
+    }
+
+    void on_recorded_interval(const typename clock_::time_point &now)
+    {
+        m_weights.push_back(m_next_weight);
+        if (m_overhead_budget <= 0)
+            return;
+
+        // a recorded interval costs two clock reads and a push back, which is about twice the
+        // time from its end to here
+        m_adapt_overhead += 2 * (clock_::now() - now);
+        m_adapt_sampled += std::get<3>(stamped.back());
+        if (++m_adapt_num_sampled < 64)
+            return;
+
+        const double overhead = timepoint_diff_to_secs(m_adapt_overhead);
+        const double sampled = timepoint_diff_to_secs(m_adapt_sampled);
+        if (sampled > 0)
+        {
+            m_sample_every = static_cast<size_t>(std::min(
+                std::max(std::ceil(overhead / (m_overhead_budget * sampled)), 1.),
+                static_cast<double>(std::numeric_limits<uint32_t>::max())
+            ));
+        }
+        m_adapt_overhead = {};
+        m_adapt_sampled = {};
+        m_adapt_num_sampled = 0;
+    }
+
+    std::vector<stamped_t> stamped;
+    // sample weight of each stamped interval, empty if never sampled
+    std::vector<uint32_t> m_weights;
 
     Token _last_stamped_token;
-    clock_::time_point _last_stamped_clock;
+    typename clock_::time_point _last_stamped_clock;
+
+    sampling_mode m_sampling = sampling_mode::none;
+    size_t m_sample_every = 1;
+    size_t m_num_skip = 0;
+    size_t m_num_intervals = 0;
+    uint32_t m_next_weight = 1;
+    bool m_last_sampled = true;
+    double m_overhead_budget = 0;
+    typename clock_::duration m_adapt_overhead{};
+    typename clock_::duration m_adapt_sampled{};
+    size_t m_adapt_num_sampled = 0;
+    std::minstd_rand m_rng;
+    std::optional<bool> m_subtract_overhead;
+    std::shared_ptr<PerfCounterSet> m_counters;
+    PerfCounterSet::Values m_last_counter_values{};
+    std::unordered_map<TimeStampCollectionKey<Token>, PerfCounterTotals, pair_hash>
+        m_counter_totals;
+    bool m_count_allocations = false;
+    AllocCounts m_last_alloc_counts;
+    std::unordered_map<TimeStampCollectionKey<Token>, AllocTotals, pair_hash> m_alloc_totals;
     std::string name;
     bool m_autoprint;
     int m_counts;
     bool m_print_starter;
 };
 
-class TimeStamperDynamic : public TimeStamperBase<std::string>
+/*
+ * A TimeStamper of labels that are only known at runtime. Labels are interned, such that stamps
+ * only store and hash small ids, and are resolved back to strings when printing.
+ */
+template <typename ClockPolicy = clock_policy::default_clock>
+class TimeStamperDynamicBase : public TimeStamperBase<InternedString, ClockPolicy>
 {
+private:
+    using self = TimeStamperBase<InternedString, ClockPolicy>;
+
 public:
+    using self::self;
+
+    void stamp(const InternedString &token)
+    {
+        self::stamp_interval(token, !self::_last_stamped_token.empty());
+    }
+
     void stamp(const std::string &stamp_string)
     {
-        if (!_last_stamped_token.empty())
-        {
-            stamped.emplace_back(
-                _last_stamped_token, stamp_string,
-                timepoint_diff_to_secs(clock_::now() - _last_stamped_clock)
-            );
-        }
-        _last_stamped_clock = clock_::now();
-        _last_stamped_token = std::move(stamp_string);
+        stamp(InternedString(stamp_string));
+    }
+
+    void stamp(const char *stamp_string)
+    {
+        stamp(InternedString(stamp_string));
     }
 };
 
-template <typename Token>
-class TimeStamper : public TimeStamperBase<Token>
+using TimeStamperDynamic = TimeStamperDynamicBase<>;
+
+template <typename Token, typename ClockPolicy = clock_policy::default_clock>
+class TimeStamper : public TimeStamperBase<Token, ClockPolicy>
 {
 private:
-    using self = TimeStamperBase<Token>;
+    using self = TimeStamperBase<Token, ClockPolicy>;
 
 protected:
     bool is_first = true;
@@ -453,19 +1008,40 @@ public:
     template <Token t>
     void stamp()
     {
-        if (!is_first)
-        {
-            self::stamped.emplace_back(
-                self::_last_stamped_token, t,
-                self::timepoint_diff_to_secs(self::clock_::now() - self::_last_stamped_clock)
-            );
-        }
+        self::stamp_interval(t, !is_first);
         is_first = false;
-        self::_last_stamped_clock = self::clock_::now();
-        self::_last_stamped_token = std::move(t);
     }
 };
 
+/*
+ * Overhead of an empty stamp-to-stamp interval with the given clock, calibrated on first use.
+ * Call it at startup to pay for the calibration up front.
+ */
+template <typename ClockPolicy>
+const MeasurementOverhead &stamp_overhead()
+{
+    static const MeasurementOverhead overhead = []()
+    {
+        constexpr size_t num_samples = 10000;
+        TimeStamper<int, ClockPolicy> stamper;
+        stamper.set_autoprint(false);
+        for (size_t i = 0; i < num_samples; ++i)
+        {
+            stamper.template stamp<0>();
+            stamper.template stamp<1>();
+        }
+
+        std::vector<double> samples;
+        samples.reserve(2 * num_samples);
+        stamper.for_each_interval(
+            [&samples](const int &, const int &, const auto &, const auto &duration)
+            { samples.push_back(ClockPolicy::to_secs(duration)); }
+        );
+        return MeasurementOverhead::from_samples(std::move(samples));
+    }();
+    return overhead;
+}
+
 }  // namespace sxs
 
 #ifdef SXS_RUN_TESTS
@@ -478,6 +1054,8 @@ public:
 #include "soraxas_toolbox/print_utils.h"
 #include "soraxas_toolbox/string.h"
 
+#include <thread>
+
 namespace __sxs_timer
 {
 
@@ -499,6 +1077,281 @@ TEST_CASE("[sxs] An int vector with some items")
     CHECK(sxs::string::contains(guard.oss().str(), "hbye"));
 }
 
+TEST_CASE("[sxs] Token pair hash")
+{
+    sxs::pair_hash hasher;
+    CHECK(hasher(std::make_pair(1, 2)) != hasher(std::make_pair(2, 1)));
+    CHECK(hasher(std::make_pair(3, 3)) != hasher(std::make_pair(5, 5)));
+}
+
+TEST_CASE("[sxs] Print percentiles of stamped result")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::TimeStamperDynamic timer;
+    timer.set_autoprint(false);
+    for (int i = 0; i < 10; ++i)
+    {
+        timer.stamp("hi");
+        timer.stamp("bye");
+    }
+
+    print_compiled_stats(compile_result(timer));
+    CHECK(!sxs::string::contains(guard.oss().str(), "p99.9"));
+
+    auto stamped = compile_result(timer, true);
+    CHECK(stamped[{"hi", "bye"}].percentile(50) <= stamped[{"hi", "bye"}].max);
+    print_aggregated_stamped_stats(
+        std::vector<sxs::TimeStampCollection<sxs::InternedString>>{stamped, stamped}
+    );
+    CHECK(sxs::string::contains(guard.oss().str(), "p99.9"));
+}
+
+template <typename ClockPolicy>
+void check_stamper_with_clock_policy()
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::TimeStamper<int, ClockPolicy> timer;
+    timer.template stamp<0>();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    timer.template stamp<1>();
+
+    auto result = compile_result(timer);
+    CHECK(result[{0, 1}].count == 1);
+    // generous bounds, as the coarse clock only ticks every few milliseconds
+    CHECK(result[{0, 1}].min > 5e-3);
+    CHECK(result[{0, 1}].min < 1);
+    CHECK(timer.elapsed() > 5e-3);
+}
+
+TEST_CASE("[sxs] Time stamper with different clock policies")
+{
+    check_stamper_with_clock_policy<sxs::clock_policy::high_resolution>();
+    check_stamper_with_clock_policy<sxs::clock_policy::steady>();
+#ifdef SXS_HAS_POSIX_CLOCKS
+    check_stamper_with_clock_policy<sxs::clock_policy::monotonic_raw>();
+    check_stamper_with_clock_policy<sxs::clock_policy::monotonic_coarse>();
+#endif
+#ifdef SXS_HAS_TSC_CLOCK
+    if (sxs::clock_policy::tsc::is_invariant())
+        check_stamper_with_clock_policy<sxs::clock_policy::tsc>();
+#endif
+}
+
+TEST_CASE("[sxs] Sampled time stamper")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+    using Stamper = sxs::TimeStamper<int>;
+    constexpr size_t num_loops = 10000;
+
+    SUBCASE("every nth")
+    {
+        Stamper timer;
+        timer.set_sampling(Stamper::sampling_mode::every_nth, 10);
+        for (size_t i = 0; i < num_loops; ++i)
+        {
+            timer.stamp<0>();
+            timer.stamp<1>();
+            timer.stamp<2>();
+        }
+        CHECK(timer.num_intervals() == 3 * num_loops - 1);
+        CHECK(timer.count() == (3 * num_loops - 1 + 9) / 10);
+
+        auto result = compile_result(timer);
+        // a period of 3 and a stride of 10 still visits every token pair
+        CHECK(result.size() == 3);
+        size_t total = 0;
+        for (auto &&item : result)
+            total += item.second.count;
+        CHECK(total == 10 * timer.count());
+    }
+
+    SUBCASE("random")
+    {
+        Stamper timer;
+        timer.set_sampling(Stamper::sampling_mode::random, 4);
+        for (size_t i = 0; i < num_loops; ++i)
+        {
+            timer.stamp<0>();
+            timer.stamp<1>();
+        }
+        auto result = compile_result(timer);
+        CHECK(timer.count() < num_loops);
+        // scaled counts estimate all intervals
+        CHECK(result[{0, 1}].count == doctest::Approx(num_loops).epsilon(0.1));
+        CHECK(result[{1, 0}].count == doctest::Approx(num_loops).epsilon(0.1));
+    }
+
+    SUBCASE("adaptive to overhead budget")
+    {
+        Stamper timer;
+        timer.set_sampling(Stamper::sampling_mode::every_nth, 1, 0.01);
+        for (size_t i = 0; i < num_loops; ++i)
+        {
+            timer.stamp<0>();
+            timer.stamp<1>();
+        }
+        // intervals are empty, so the overhead dominates
+        CHECK(timer.sample_every() > 1);
+        CHECK(timer.count() < timer.num_intervals());
+
+        timer.print_stamped_stats();
+        CHECK(sxs::string::contains(guard.oss().str(), "intervals (currently 1 in"));
+    }
+
+    SUBCASE("turn sampling off after stamping")
+    {
+        Stamper timer;
+        timer.set_sampling(Stamper::sampling_mode::every_nth, 4);
+        for (size_t i = 0; i < 10; ++i)
+        {
+            timer.stamp<0>();
+            timer.stamp<1>();
+        }
+        const size_t sampled = timer.count();
+        timer.set_sampling(Stamper::sampling_mode::none);
+        for (size_t i = 0; i < 10; ++i)
+        {
+            timer.stamp<0>();
+            timer.stamp<1>();
+        }
+        // every interval after the one in progress is recorded, each standing for itself
+        CHECK(timer.count() >= sampled + 19);
+        size_t total = 0;
+        for (auto &&item : compile_result(timer))
+            total += item.second.count;
+        CHECK(total == 4 * sampled + (timer.count() - sampled));
+
+        Stamper never_sampled;
+        never_sampled.stamp<0>();
+        never_sampled.stamp<1>();
+        never_sampled.set_sampling(Stamper::sampling_mode::none);
+        never_sampled.stamp<0>();
+        CHECK(compile_result(never_sampled).size() == 2);
+    }
+}
+
+TEST_CASE("[sxs] Aggregate many stampers in parallel")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    std::vector<sxs::TimeStamper<int>> stampers(37);
+    for (size_t i = 0; i < stampers.size(); ++i)
+    {
+        stampers[i].set_autoprint(false);
+        // token pairs first appear in different stampers
+        for (size_t j = 0; j <= i % 5; ++j)
+        {
+            stampers[i].stamp<0>();
+            stampers[i].stamp<1>();
+        }
+        if (i == 20)
+            stampers[i].stamp<2>();
+    }
+
+    const auto serial = sxs::compile_aggregated(stampers, 1);
+    for (size_t num_workers : {2, 3, 8, 64})
+    {
+        const auto parallel = sxs::compile_aggregated(stampers, num_workers);
+        REQUIRE(parallel.size() == serial.size());
+        auto it = parallel.begin();
+        for (auto &&item : serial)
+        {
+            CHECK(it->first == item.first);
+            CHECK(it->second.count == item.second.count);
+            CHECK(it->second.mean() == doctest::Approx(item.second.mean()));
+            CHECK(it->second.stdev() == doctest::Approx(item.second.stdev()));
+            ++it;
+        }
+    }
+    CHECK(serial.at({1, 2}).count == 1);
+
+    print_aggregated_stamped_stats(stampers);
+    CHECK(sxs::string::contains(guard.oss().str(), "stamped result"));
+}
+
+TEST_CASE("[sxs] Measurement overhead subtraction")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    const auto &overhead = sxs::stamp_overhead<sxs::clock_policy::default_clock>();
+    CHECK(overhead.overhead > 0);
+    CHECK(overhead.noise_floor >= overhead.overhead);
+    CHECK(sxs::timeit_overhead().noise_floor >= sxs::timeit_overhead().overhead);
+
+    sxs::TimeStamper<int> timer;
+    timer.set_autoprint(false);
+    for (int i = 0; i < 1000; ++i)
+    {
+        timer.stamp<0>();
+        timer.stamp<1>();
+    }
+    const double raw_mean = compile_result(timer)[{0, 1}].mean();
+
+    timer.set_subtract_overhead();
+    const auto subtracted = compile_result(timer)[{0, 1}];
+    CHECK(subtracted.mean() < raw_mean);
+    CHECK(subtracted.min >= 0);
+
+    // empty intervals are all noise
+    timer.print_stamped_stats();
+    CHECK(sxs::string::contains(guard.oss().str(), "(within measurement noise)"));
+}
+
+TEST_CASE("[sxs] Perf counters per stamped interval")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::TimeStamper<int> timer;
+    timer.set_autoprint(false);
+    if (!timer.enable_counters())
+        return;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        timer.stamp<0>();
+        std::vector<char> memory(1 << 20);
+        for (size_t j = 0; j < memory.size(); j += 4096)
+            memory[j] = 1;
+        timer.stamp<1>();
+    }
+    // one total per interval that was recorded
+    CHECK(timer.counter_totals().at({0, 1}).count == 10);
+    CHECK(timer.counter_totals().at({1, 0}).count == 9);
+
+    timer.print_stamped_stats();
+    CHECK(sxs::string::contains(guard.oss().str(), timer.counters()->name(0)));
+
+    timer.reset();
+    CHECK(timer.counter_totals().empty());
+}
+
+TEST_CASE("[sxs] Heap allocations per stamped interval")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+
+    sxs::TimeStamper<int> timer;
+    timer.set_autoprint(false);
+    if (!timer.enable_alloc_counts())
+        return;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        timer.stamp<0>();
+        std::vector<char> allocating(64);
+        timer.stamp<1>();
+    }
+    // the stamper's own growth is not attributed to any interval
+    CHECK(timer.alloc_totals().at({0, 1}).sums.allocations == 100);
+    CHECK(timer.alloc_totals().at({0, 1}).sums.bytes == 100 * 64);
+    CHECK(timer.alloc_totals().at({1, 0}).sums.allocations == 0);
+    CHECK(timer.alloc_totals().at({1, 0}).sums.deallocations == 99);
+
+    timer.print_stamped_stats();
+    CHECK(sxs::string::contains(guard.oss().str(), "{allocs 1|bytes 64|frees 0}"));
+}
+
 #ifdef SXS_HAS_ENUM_HPP
 SXS_DEFINE_ENUM_AND_TRAITS(
     my_smart_enum, char,  //
@@ -519,9 +1372,19 @@ TEST_CASE("[sxs] An int vector with some items")
     timer.stamp<my_smart_enum::myval2>();
     timer.stamp<my_smart_enum::myval3>();
 
-    sxs::println(timer);
+    sxs::println(std::string(timer));
 
-    print_compiled_stats(compile_result(timer));
+    auto stamped = compile_result(timer);
+    // dense table keeps the order that token pairs first appeared
+    REQUIRE(stamped.size() == 4);
+    auto it = stamped.begin();
+    CHECK((it++)->first == std::make_pair(my_smart_enum::myval1, my_smart_enum::myval1));
+    CHECK((it++)->first == std::make_pair(my_smart_enum::myval1, my_smart_enum::myval2));
+    CHECK((it++)->first == std::make_pair(my_smart_enum::myval2, my_smart_enum::myval3));
+    CHECK((it++)->first == std::make_pair(my_smart_enum::myval3, my_smart_enum::myval2));
+    CHECK(stamped[{my_smart_enum::myval2, my_smart_enum::myval3}].count == 2);
+
+    print_compiled_stats(stamped);
     CHECK(sxs::string::contains(guard.oss().str(), "myval1"));
     CHECK(sxs::string::contains(guard.oss().str(), "myval3"));
     CHECK(!sxs::string::contains(guard.oss().str(), "myval3notexists"));
@@ -36,6 +36,12 @@ namespace sxs
 
 template <typename Token>
 using TimeStamperStatIteratorReturnType = std::tuple<Token, Token, double>;
+
+/*
+ * Same as above, plus the number of intervals that the sampled interval stands for.
+ */
+template <typename Token>
+using TimeStamperWeightedStatIteratorReturnType = std::tuple<Token, Token, double, size_t>;
 //
 //    // member typedefs provided through inheriting from std::iterator
 //    template <typename Token>
@@ -27,52 +27,143 @@
 
 #pragma once
 
+#include "histogram.h"
 #include "token.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
-#include <math.h>
+#include <optional>
 
 namespace sxs
 {
 
+/*
+ * Running statistics of a stream of samples.
+ *
+ * Mean and variance are kept as online (Welford) moments, such that samples can be added one at a
+ * time in O(1) memory, and two partial results can be merged exactly (Chan et al.).
+ * Percentiles are only available once a histogram is enabled (see enable_histogram()).
+ */
 template <typename DataType = float>
 struct Stats
 {
     DataType min = std::numeric_limits<DataType>::max();
-    DataType max = std::numeric_limits<DataType>::min();
-    std::pair<DataType, DataType> mean_stdev = {0, std::numeric_limits<DataType>::quiet_NaN()};
+    DataType max = std::numeric_limits<DataType>::lowest();
     DataType sum = 0;
     size_t count = 0;
+    // running mean, and sum of squares of differences from the mean
+    DataType mean_ = 0;
+    DataType m2 = 0;
+    // optional, as it costs a fixed but non-trivial amount of memory
+    std::optional<LogHistogram<>> histogram;
+
+    void enable_histogram()
+    {
+        if (!histogram)
+            histogram.emplace();
+    }
+
+    /*
+     * Value at the given percentile (0 ~ 100), or NaN if no histogram is enabled.
+     */
+    inline DataType percentile(double percentile) const
+    {
+        if (!histogram || histogram->total_count() == 0)
+            return std::numeric_limits<DataType>::quiet_NaN();
+        return std::min(
+            std::max(static_cast<DataType>(histogram->value_at_percentile(percentile)), min), max
+        );
+    }
+
+    inline const DataType &mean() const
+    {
+        return mean_;
+    }
+
+    inline DataType variance() const
+    {
+        if (count < 2)
+            return count == 1 ? 0 : std::numeric_limits<DataType>::quiet_NaN();
+        return m2 / (count - 1);
+    }
 
-    const inline DataType &mean() const
+    inline DataType stdev() const
     {
-        return mean_stdev.first;
+        return std::sqrt(variance());
     }
 
-    const inline DataType &stdev() const
+    inline std::pair<DataType, DataType> mean_stdev() const
     {
-        return mean_stdev.second;
+        return {mean(), stdev()};
     }
 
-    inline DataType &mean()
+    inline void add(const DataType val)
     {
-        return mean_stdev.first;
+        ++count;
+        sum += val;
+        min = std::min(val, min);
+        max = std::max(val, max);
+
+        const DataType delta = val - mean_;
+        mean_ += delta / count;
+        m2 += delta * (val - mean_);
+
+        if (histogram)
+            histogram->record(val);
     }
 
-    inline DataType &stdev()
+    /*
+     * Add a sample that stands for `weight` identical samples, e.g., one that was sampled with a
+     * probability of 1 / weight.
+     */
+    inline void add(const DataType val, size_t weight)
     {
-        return mean_stdev.second;
+        if (weight == 1)
+            return add(val);
+        count += weight;
+        sum += val * weight;
+        min = std::min(val, min);
+        max = std::max(val, max);
+
+        const DataType delta = val - mean_;
+        mean_ += delta * weight / count;
+        m2 += weight * delta * (val - mean_);
+
+        if (histogram)
+            histogram->record(val, weight);
     }
 
+    /*
+     * Merge the samples of another Stats. The histogram is only kept if it can hold all samples of
+     * both, i.e. if both have one (or this has no samples yet, and rhs has one), as percentiles
+     * over a subset of the samples would not match the other statistics.
+     */
     void accumulate_standard(const Stats &rhs)
     {
-        // combine stdev with
-        // https://math.stackexchange.com/questions/2971315/how-do-i-combine-standard-deviations-of-two-groups
-        stdev() = ((count - 1) * std::pow(stdev(), 2) + (rhs.count - 1) * std::pow(rhs.stdev(), 2)
-                  ) / (count + rhs.count - 1) +
-                  ((count * rhs.count) * std::pow(mean() - rhs.mean(), 2)) /
-                      ((count + rhs.count) * (count + rhs.count - 1));
-        mean() = mean() * count + rhs.mean() * rhs.count;
+        // combine moments of two groups, see
+        // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm
+        if (rhs.count == 0)
+            return;
+        if (count == 0)
+        {
+            min = rhs.min;
+            max = rhs.max;
+            sum = rhs.sum;
+            count = rhs.count;
+            mean_ = rhs.mean_;
+            m2 = rhs.m2;
+            histogram = rhs.histogram;
+            return;
+        }
+        if (histogram && rhs.histogram)
+            histogram->merge(*rhs.histogram);
+        else
+            histogram.reset();
+        const DataType total = static_cast<DataType>(count + rhs.count);
+        const DataType delta = rhs.mean_ - mean_;
+        mean_ += delta * rhs.count / total;
+        m2 += rhs.m2 + delta * delta * count * rhs.count / total;
 
         min = std::min(min, rhs.min);
         max = std::max(max, rhs.max);
@@ -80,12 +171,117 @@ struct Stats
         sum += rhs.sum;
     }
 
-    void accumulate_without_mean_stdev(const Stats &rhs)
+    // for cereal, see soraxas_toolbox/cereal/stats.h
+    template <class Archive>
+    void serialize(Archive &archive)
     {
-        min = std::min(min, rhs.min);
-        max = std::max(max, rhs.max);
-        count += rhs.count;
-        sum += rhs.sum;
+        archive(min, max, sum, count, mean_, m2, histogram);
     }
 };
 };  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include "soraxas_toolbox/vector_math.h"
+
+namespace __sxs_timing
+{
+
+TEST_CASE("[sxs] Running stats moments")
+{
+    std::vector<double> v = {1.5, 2.9, 33.4, 0.2, 7.7, 7.7};
+
+    sxs::Stats<double> stats;
+    for (auto &&val : v)
+        stats.add(val);
+
+    auto mean_stdev = sxs::compute_mean_and_stdev(v);
+    CHECK(stats.count == v.size());
+    CHECK(stats.sum == doctest::Approx(sxs::compute_sum(v)));
+    CHECK(stats.mean() == doctest::Approx(mean_stdev.first));
+    CHECK(stats.stdev() == doctest::Approx(mean_stdev.second));
+    CHECK(stats.min == doctest::Approx(0.2));
+    CHECK(stats.max == doctest::Approx(33.4));
+
+    SUBCASE("merging partial stats equals a single pass")
+    {
+        sxs::Stats<double> first, second, merged;
+        for (size_t i = 0; i < v.size(); ++i)
+            (i < 2 ? first : second).add(v[i]);
+        merged.accumulate_standard(first);
+        merged.accumulate_standard(second);
+
+        CHECK(merged.count == stats.count);
+        CHECK(merged.mean() == doctest::Approx(stats.mean()));
+        CHECK(merged.stdev() == doctest::Approx(stats.stdev()));
+        CHECK(merged.min == doctest::Approx(stats.min));
+        CHECK(merged.max == doctest::Approx(stats.max));
+    }
+
+    SUBCASE("weighted samples equal repeated samples")
+    {
+        sxs::Stats<double> weighted, repeated;
+        for (auto &&val : v)
+        {
+            weighted.add(val, 3);
+            for (int i = 0; i < 3; ++i)
+                repeated.add(val);
+        }
+        CHECK(weighted.count == repeated.count);
+        CHECK(weighted.sum == doctest::Approx(repeated.sum));
+        CHECK(weighted.mean() == doctest::Approx(repeated.mean()));
+        CHECK(weighted.stdev() == doctest::Approx(repeated.stdev()));
+    }
+
+    SUBCASE("percentiles are only available with a histogram")
+    {
+        CHECK(std::isnan(stats.percentile(50)));
+
+        sxs::Stats<double> with_histogram;
+        with_histogram.enable_histogram();
+        for (auto &&val : v)
+            with_histogram.add(val);
+        CHECK(with_histogram.percentile(50) == doctest::Approx(2.9).epsilon(1. / 64));
+        // clamped to the recorded range
+        CHECK(with_histogram.percentile(100) == doctest::Approx(33.4));
+        CHECK(with_histogram.percentile(0) == doctest::Approx(0.2).epsilon(1. / 64));
+
+        // merged percentiles are only kept if they cover every sample
+        sxs::Stats<double> merged = with_histogram;
+        merged.accumulate_standard(with_histogram);
+        CHECK(merged.percentile(50) == doctest::Approx(2.9).epsilon(1. / 64));
+        merged.accumulate_standard(stats);
+        CHECK(merged.count == 3 * v.size());
+        CHECK(std::isnan(merged.percentile(50)));
+
+        sxs::Stats<double> without_histogram = stats;
+        without_histogram.accumulate_standard(with_histogram);
+        CHECK(std::isnan(without_histogram.percentile(50)));
+
+        sxs::Stats<double> empty;
+        empty.enable_histogram();
+        empty.accumulate_standard(stats);
+        CHECK(empty.count == v.size());
+        CHECK(std::isnan(empty.percentile(50)));
+        sxs::Stats<double> empty_with_histogram;
+        empty_with_histogram.enable_histogram();
+        empty_with_histogram.accumulate_standard(with_histogram);
+        CHECK(empty_with_histogram.percentile(50) == doctest::Approx(2.9).epsilon(1. / 64));
+    }
+
+    SUBCASE("single sample has zero stdev")
+    {
+        sxs::Stats<double> single;
+        single.add(-4);
+        CHECK(single.stdev() == 0);
+        CHECK(single.max == -4);
+    }
+}
+
+}  // namespace __sxs_timing
+#endif  // SXS_RUN_TESTS
@@ -41,6 +41,7 @@
 #include "soraxas_toolbox/metaprogramming.h"
 
 #include <string>
+#include <type_traits>
 
 namespace sxs
 {
@@ -105,6 +106,58 @@ namespace stats
         return token;
     }
 
+#ifdef SXS_HAS_ENUM_HPP
+    /*
+     * Whether the token is an enum registered with enum.hpp, i.e., its cardinality is known at
+     * compile time.
+     */
+    template <typename Token>
+    constexpr bool is_enum_hpp_token()
+    {
+        if constexpr (std::is_enum<Token>::value)
+            return has_function_enum_hpp_adl_find_registered_traits<Token>::value;
+        else
+            return false;
+    }
+
+    /*
+     * Whether the enum values are exactly 0, 1, ..., N-1, such that they are their own index.
+     */
+    template <typename Token>
+    constexpr bool has_contiguous_token_values()
+    {
+        constexpr auto values = enum_hpp::values<Token>();
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (static_cast<size_t>(values[i]) != i)
+                return false;
+        }
+        return true;
+    }
+
+    /*
+     * Index of an enum.hpp token within [0, N), or N if the value is not registered.
+     */
+    template <typename Token>
+    constexpr inline size_t get_token_index(const Token &token)
+    {
+        constexpr size_t num_tokens = enum_hpp::size<Token>();
+        if constexpr (has_contiguous_token_values<Token>())
+        {
+            const auto index = static_cast<size_t>(token);
+            return index < num_tokens ? index : num_tokens;
+        }
+        else
+            return enum_hpp::to_index(token).value_or(num_tokens);
+    }
+
+    template <typename Token>
+    constexpr inline Token get_token_from_index(size_t index)
+    {
+        return enum_hpp::values<Token>()[index];
+    }
+#endif  // SXS_HAS_ENUM_HPP
+
 }  // namespace stats
 }  // namespace sxs
 
@@ -0,0 +1,749 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "interned_string.h"
+#include "timer.h"
+
+#include "../clock.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SXS_HAS_MMAP
+#endif
+
+#ifdef SXS_HAS_MMAP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sxs
+{
+
+/*
+ * A fixed-size record of a trace log: the thread that stamped, its token, and the raw clock tick.
+ */
+struct TraceRecord
+{
+    uint32_t thread;
+    uint32_t token;
+    int64_t tick;
+};
+static_assert(sizeof(TraceRecord) == 16, "");
+
+/*
+ * Layout of the first page of a trace log file; records start at records_offset.
+ */
+struct TraceLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t records_offset;
+    uint64_t num_records;
+    // seconds per clock tick, such that a log can be read without its clock
+    double secs_per_tick;
+    // offset of the interned names section, or 0 if there is none
+    uint64_t names_offset;
+};
+
+constexpr char trace_log_magic[8] = {'S', 'X', 'S', 'T', 'R', 'A', 'C', 'E'};
+constexpr uint32_t trace_log_version = 1;
+// the number of records of a log that was never closed (e.g. its process crashed)
+constexpr uint64_t trace_log_unfinished = ~uint64_t(0);
+
+/*
+ * Tokens are stored as 32 bits integers: enums and integers as is, interned strings as their id.
+ */
+template <typename Token>
+inline uint32_t to_trace_token(const Token &token)
+{
+    static_assert(
+        std::is_integral<Token>::value || std::is_enum<Token>::value,
+        "Only integral, enum or interned string tokens can be stored in a trace log"
+    );
+    return static_cast<uint32_t>(token);
+}
+
+inline uint32_t to_trace_token(const InternedString &token)
+{
+    return token.id();
+}
+
+/*
+ * A small index per thread, in the order threads first stamp into any trace log.
+ */
+inline uint32_t trace_thread_index()
+{
+    static std::atomic<uint32_t> num_threads{0};
+    thread_local const uint32_t index = num_threads++;
+    return index;
+}
+
+/*
+ * Appends (thread, token, tick) records to a memory-mapped file, for runs that are too long to
+ * keep every stamp in memory. Any number of threads can stamp into the same log.
+ *
+ * The file grows by whole chunks, each mapped once, such that a stamp is only an atomic increment
+ * and a store into memory; the kernel writes the pages back in the background. Call close() (or
+ * destroy the log) once all threads are done stamping. Read it back with TraceLogReader.
+ *
+ * The header is written when the log is opened, such that the records of a run that never closed
+ * its log (e.g. it crashed or was killed) can still be read, although not the names of interned
+ * string tokens, which are only written by close().
+ */
+template <typename Token, typename ClockPolicy = clock_policy::default_clock>
+class TraceLog
+{
+public:
+    explicit TraceLog(const std::string &filename, size_t chunk_size = size_t(64) << 20)
+    {
+        const size_t page_size = sysconf(_SC_PAGESIZE);
+        // chunks must start at page boundaries to be mapped
+        chunk_size_ = std::max(page_size, chunk_size / page_size * page_size);
+        records_per_chunk_ = chunk_size_ / sizeof(TraceRecord);
+        records_offset_ = std::max(page_size, sizeof(TraceLogHeader));
+
+        fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0)
+            throw std::runtime_error("Unable to open trace log " + filename);
+        for (auto &&chunk : chunks_)
+            chunk.store(nullptr, std::memory_order_relaxed);
+        map_chunk(0);
+        if (!write_header(trace_log_unfinished, 0))
+            throw std::runtime_error("Unable to write trace log header " + filename);
+    }
+
+    ~TraceLog()
+    {
+        try
+        {
+            close();
+        }
+        catch (const std::runtime_error &error)
+        {
+            sxs::println("[TraceLog] ", error.what());
+        }
+    }
+
+    TraceLog(const TraceLog &) = delete;
+    TraceLog &operator=(const TraceLog &) = delete;
+
+    template <auto token>
+    inline void stamp()
+    {
+        stamp(token);
+    }
+
+    inline void stamp(const Token &token)
+    {
+        const TraceRecord record{
+            trace_thread_index(), to_trace_token(token),
+            ClockPolicy::now().time_since_epoch().count()
+        };
+        const size_t index = num_records_.fetch_add(1, std::memory_order_relaxed);
+        const size_t chunk = index / records_per_chunk_;
+        TraceRecord *records = chunk < max_chunks ? chunks_[chunk].load(std::memory_order_acquire)
+                                                  : nullptr;
+        if (records == nullptr)
+            records = map_chunk(chunk);
+        records[index % records_per_chunk_] = record;
+    }
+
+    size_t count() const
+    {
+        return num_records_.load();
+    }
+
+    /*
+     * Unmap the file, truncate it to the records stamped, and write the header (and the names of
+     * interned string tokens). Stamping afterwards throws.
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (fd_ < 0)
+            return;
+        // a later stamp() then finds no chunk, and map_chunk() throws rather than writing into
+        // unmapped memory
+        for (size_t i = 0; i < max_chunks; ++i)
+        {
+            if (auto *records = chunks_[i].exchange(nullptr))
+                ::munmap(records, chunk_size_);
+        }
+
+        const uint64_t num_records = num_records_.load();
+        const uint64_t records_end = records_offset_ + num_records * sizeof(TraceRecord);
+        uint64_t names_offset = 0;
+        bool ok = ::ftruncate(fd_, records_end) == 0;
+        if constexpr (std::is_same<Token, InternedString>::value)
+        {
+            names_offset = records_end;
+            ok &= write_names(records_end);
+        }
+        ok &= write_header(num_records, names_offset);
+        ::close(fd_);
+        fd_ = -1;
+        if (!ok)
+            throw std::runtime_error("Unable to finalise trace log");
+    }
+
+    static constexpr size_t max_chunks = 4096;
+
+protected:
+    TraceRecord *map_chunk(size_t chunk)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (fd_ < 0)
+            throw std::runtime_error("Trace log is closed");
+        if (chunk >= max_chunks)
+            throw std::runtime_error("Trace log is full");
+        if (auto *records = chunks_[chunk].load(std::memory_order_acquire))
+            // mapped by another thread in the meantime
+            return records;
+
+        // chunks can be requested out of order by racing threads, and the file must never shrink
+        const off_t offset = records_offset_ + chunk * chunk_size_;
+        if (offset + chunk_size_ > file_size_)
+        {
+            if (::ftruncate(fd_, offset + chunk_size_) != 0)
+                throw std::runtime_error("Unable to grow trace log");
+            file_size_ = offset + chunk_size_;
+        }
+        void *mapped =
+            ::mmap(nullptr, chunk_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+        if (mapped == MAP_FAILED)
+            throw std::runtime_error("Unable to map trace log");
+        auto *records = static_cast<TraceRecord *>(mapped);
+        chunks_[chunk].store(records, std::memory_order_release);
+        return records;
+    }
+
+    bool write_header(uint64_t num_records, uint64_t names_offset)
+    {
+        TraceLogHeader header{};
+        std::memcpy(header.magic, trace_log_magic, sizeof(header.magic));
+        header.version = trace_log_version;
+        header.record_size = sizeof(TraceRecord);
+        header.records_offset = records_offset_;
+        header.num_records = num_records;
+        header.secs_per_tick = ClockPolicy::to_secs(typename ClockPolicy::duration(1));
+        header.names_offset = names_offset;
+        return ::pwrite(fd_, &header, sizeof(header), 0) == sizeof(header);
+    }
+
+    bool write_names(uint64_t offset)
+    {
+        // [num names] then [length, bytes] of each name, in id order
+        std::string section;
+        const auto num_names = static_cast<uint32_t>(StringInterner::instance().size());
+        section.append(reinterpret_cast<const char *>(&num_names), sizeof(num_names));
+        for (uint32_t id = 0; id < num_names; ++id)
+        {
+            const std::string &name = StringInterner::instance().name(id);
+            const auto length = static_cast<uint32_t>(name.size());
+            section.append(reinterpret_cast<const char *>(&length), sizeof(length));
+            section.append(name);
+        }
+        return ::pwrite(fd_, section.data(), section.size(), offset) ==
+               static_cast<ssize_t>(section.size());
+    }
+
+    int fd_ = -1;
+    size_t chunk_size_;
+    size_t records_per_chunk_;
+    size_t records_offset_;
+    size_t file_size_ = 0;
+    std::atomic<size_t> num_records_{0};
+    std::array<std::atomic<TraceRecord *>, max_chunks> chunks_;
+    std::mutex lock_;
+};
+
+/*
+ * Replays a trace log as stamped intervals, i.e., the consecutive records of each thread, such
+ * that it can be compiled with compile_result() or compile_parallel().
+ */
+template <typename Token>
+class TraceLogReader
+{
+public:
+    using stat_t = TimeStamperStatIteratorReturnType<Token>;
+
+    explicit TraceLogReader(const std::string &filename)
+    {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Unable to open trace log " + filename);
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)sizeof(TraceLogHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error("Invalid trace log " + filename);
+        }
+        size_ = file_stat.st_size;
+        data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data_ == MAP_FAILED)
+            throw std::runtime_error("Unable to map trace log " + filename);
+
+        std::memcpy(&header_, data_, sizeof(header_));
+        if (std::memcmp(header_.magic, trace_log_magic, sizeof(header_.magic)) != 0 ||
+            header_.version != trace_log_version || header_.record_size != sizeof(TraceRecord) ||
+            header_.records_offset > size_)
+        {
+            ::munmap(data_, size_);
+            throw std::runtime_error("Invalid trace log " + filename);
+        }
+        records_ = reinterpret_cast<const TraceRecord *>(
+            static_cast<const char *>(data_) + header_.records_offset
+        );
+        if (header_.num_records == trace_log_unfinished)
+            recover_num_records();
+        if (header_.records_offset + header_.num_records * sizeof(TraceRecord) > size_)
+        {
+            ::munmap(data_, size_);
+            throw std::runtime_error("Invalid trace log " + filename);
+        }
+
+        try
+        {
+            if constexpr (std::is_same<Token, InternedString>::value)
+                read_names();
+            for (size_t i = 0; i < header_.num_records; ++i)
+            {
+                num_threads_ = std::max<size_t>(num_threads_, records_[i].thread + 1);
+                if constexpr (std::is_same<Token, InternedString>::value)
+                    if (records_[i].token >= names_.size())
+                        throw std::runtime_error("Unknown token in trace log " + filename);
+            }
+        }
+        catch (...)
+        {
+            ::munmap(data_, size_);
+            throw;
+        }
+    }
+
+    /*
+     * Whether the log was closed by its writer. Otherwise, its records were recovered up to the
+     * last one written, although the ones that were being written at the time may read as zeros.
+     */
+    bool is_finished() const
+    {
+        return finished_;
+    }
+
+    ~TraceLogReader()
+    {
+        ::munmap(data_, size_);
+    }
+
+    TraceLogReader(const TraceLogReader &) = delete;
+    TraceLogReader &operator=(const TraceLogReader &) = delete;
+
+    size_t num_records() const
+    {
+        return header_.num_records;
+    }
+
+    const TraceRecord &record(size_t i) const
+    {
+        return records_[i];
+    }
+
+    inline Token token_of(const TraceRecord &record) const
+    {
+        if constexpr (std::is_same<Token, InternedString>::value)
+            return names_[record.token];
+        else
+            return static_cast<Token>(record.token);
+    }
+
+    /*
+     * Iterates over the intervals that end within [first, last) records, and start within them.
+     */
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = stat_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const stat_t *;
+        using reference = stat_t;
+
+        iterator(const TraceLogReader &reader, size_t index, size_t last)
+          : reader_(&reader), index_(index), last_(last)
+          , previous_(reader.num_threads_, nullptr)
+        {
+            settle();
+        }
+
+        iterator &operator++()
+        {
+            previous_[reader_->records_[index_].thread] = &reader_->records_[index_];
+            ++index_;
+            settle();
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+        stat_t operator*() const
+        {
+            const TraceRecord &record = reader_->records_[index_];
+            const TraceRecord &previous = *previous_[record.thread];
+            return stat_t{
+                reader_->token_of(previous), reader_->token_of(record),
+                (record.tick - previous.tick) * reader_->header_.secs_per_tick
+            };
+        }
+
+    private:
+        // skip to the next record that ends an interval, i.e., whose thread has stamped before
+        void settle()
+        {
+            while (index_ < last_ && previous_[reader_->records_[index_].thread] == nullptr)
+            {
+                previous_[reader_->records_[index_].thread] = &reader_->records_[index_];
+                ++index_;
+            }
+        }
+
+        const TraceLogReader *reader_;
+        size_t index_;
+        size_t last_;
+        std::vector<const TraceRecord *> previous_;
+    };
+
+    iterator begin() const
+    {
+        return iterator(*this, 0, num_records());
+    }
+
+    iterator end() const
+    {
+        return iterator(*this, num_records(), num_records());
+    }
+
+    bool check_validity() const
+    {
+        return true;
+    }
+
+    /*
+     * Same as compile_result(reader), but compiles contiguous ranges of records on separate
+     * threads, then merges them and stitches the intervals that span two ranges.
+     */
+    TimeStampCollection<Token> compile_parallel(
+        size_t num_workers = std::max(1u, std::thread::hardware_concurrency()),
+        bool with_percentiles = compile_with_percentiles()
+    ) const
+    {
+        const size_t num_ranges = std::max<size_t>(1, std::min(num_workers, num_records()));
+        const size_t range_size = (num_records() + num_ranges - 1) / num_ranges;
+
+        struct RangeResult
+        {
+            TimeStampCollection<Token> compiled;
+            // first and last record of each thread within the range
+            std::vector<const TraceRecord *> first, last;
+        };
+
+        std::vector<std::future<RangeResult>> futures;
+        for (size_t range = 0; range < num_ranges; ++range)
+        {
+            const size_t first = std::min(range * range_size, num_records());
+            const size_t last = std::min(first + range_size, num_records());
+            futures.push_back(std::async(
+                std::launch::async,
+                [this, first, last, with_percentiles]()
+                {
+                    RangeResult result;
+                    RangeView view{this, first, last};
+                    result.compiled = compile_result(view, with_percentiles);
+                    result.first.resize(num_threads_, nullptr);
+                    result.last.resize(num_threads_, nullptr);
+                    for (size_t i = first; i < last; ++i)
+                    {
+                        const TraceRecord &record = records_[i];
+                        if (result.first[record.thread] == nullptr)
+                            result.first[record.thread] = &record;
+                        result.last[record.thread] = &record;
+                    }
+                    return result;
+                }
+            ));
+        }
+
+        TimeStampCollection<Token> merged;
+        std::vector<const TraceRecord *> last_seen(num_threads_, nullptr);
+        for (auto &&future : futures)
+        {
+            RangeResult result = future.get();
+            for (auto &&item : result.compiled)
+                merged[item.first].accumulate_standard(item.second);
+            for (size_t thread = 0; thread < num_threads_; ++thread)
+            {
+                if (result.first[thread] == nullptr)
+                    continue;
+                if (last_seen[thread] != nullptr)
+                {
+                    auto &stat = merged[std::make_pair(
+                        token_of(*last_seen[thread]), token_of(*result.first[thread])
+                    )];
+                    if (with_percentiles && stat.count == 0)
+                        stat.enable_histogram();
+                    stat.add(
+                        (result.first[thread]->tick - last_seen[thread]->tick) *
+                        header_.secs_per_tick
+                    );
+                }
+                last_seen[thread] = result.last[thread];
+            }
+        }
+        return merged;
+    }
+
+protected:
+    struct RangeView
+    {
+        using stat_t = typename TraceLogReader::stat_t;
+        const TraceLogReader *reader;
+        size_t first, last;
+
+        iterator begin() const
+        {
+            return iterator(*reader, first, last);
+        }
+
+        iterator end() const
+        {
+            return iterator(*reader, last, last);
+        }
+    };
+
+    // the records of a log that was never closed end at the last one with a (non-zero) tick, as
+    // the file grows by zero-filled chunks
+    void recover_num_records()
+    {
+        finished_ = false;
+        size_t num_records = (size_ - header_.records_offset) / sizeof(TraceRecord);
+        while (num_records > 0 && records_[num_records - 1].tick == 0)
+            --num_records;
+        header_.num_records = num_records;
+    }
+
+    void read_names()
+    {
+        if (header_.names_offset == 0)
+            throw std::runtime_error(
+                finished_ ? "Trace log has no names for its interned string tokens"
+                          : "Trace log was not closed, and has no names for its interned string "
+                            "tokens"
+            );
+        const char *section = static_cast<const char *>(data_) + header_.names_offset;
+        const char *section_end = static_cast<const char *>(data_) + size_;
+        auto read_u32 = [&section, section_end]()
+        {
+            uint32_t value;
+            if (section + sizeof(value) > section_end)
+                throw std::runtime_error("Truncated names in trace log");
+            std::memcpy(&value, section, sizeof(value));
+            section += sizeof(value);
+            return value;
+        };
+        // ids of the writing process are re-interned into this process
+        const uint32_t num_names = read_u32();
+        names_.reserve(num_names);
+        for (uint32_t i = 0; i < num_names; ++i)
+        {
+            const uint32_t length = read_u32();
+            if (section + length > section_end)
+                throw std::runtime_error("Truncated names in trace log");
+            names_.emplace_back(std::string(section, length));
+            section += length;
+        }
+    }
+
+    void *data_;
+    size_t size_;
+    TraceLogHeader header_;
+    const TraceRecord *records_;
+    size_t num_threads_ = 0;
+    bool finished_ = true;
+    std::vector<InternedString> names_;
+};
+
+}  // namespace sxs
+
+#ifdef SXS_RUN_TESTS
+/*
+ * -------------------------------------------
+ * Test cases and general usage for this file:
+ * -------------------------------------------
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+namespace __sxs_trace_log
+{
+
+TEST_CASE("[sxs] Memory-mapped trace log")
+{
+    sxs::SXSPrintOutputStreamGuard guard;
+    const std::string filename =
+        (std::filesystem::temp_directory_path() / "sxs_trace_log_test.bin").string();
+
+    constexpr size_t num_loops = 3000;
+    {
+        // a single page per chunk, to grow many times
+        sxs::TraceLog<int> log(filename, 1);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t)
+            threads.emplace_back(
+                [&log]()
+                {
+                    for (size_t i = 0; i < num_loops; ++i)
+                    {
+                        log.stamp<0>();
+                        log.stamp<1>();
+                    }
+                }
+            );
+        for (auto &&thread : threads)
+            thread.join();
+        CHECK(log.count() == 3 * 2 * num_loops);
+    }
+
+    sxs::TraceLogReader<int> reader(filename);
+    CHECK(reader.num_records() == 3 * 2 * num_loops);
+
+    auto sequential = compile_result(reader);
+    CHECK(sequential[{0, 1}].count == 3 * num_loops);
+    CHECK(sequential[{1, 0}].count == 3 * (num_loops - 1));
+    CHECK(sequential[{0, 1}].min >= 0);
+
+    for (size_t num_workers : {1, 2, 7})
+    {
+        auto parallel = reader.compile_parallel(num_workers);
+        CHECK(parallel.size() == sequential.size());
+        for (auto &&item : sequential)
+        {
+            CHECK(parallel[item.first].count == item.second.count);
+            CHECK(parallel[item.first].sum == doctest::Approx(item.second.sum));
+        }
+    }
+    print_compiled_stats(sequential);
+
+    SUBCASE("interned string tokens")
+    {
+        {
+            sxs::TraceLog<sxs::InternedString> log(filename);
+            log.stamp("trace begin");
+            log.stamp("trace end");
+        }
+        sxs::TraceLogReader<sxs::InternedString> string_reader(filename);
+        auto stamped = compile_result(string_reader);
+        CHECK(stamped[{"trace begin", "trace end"}].count == 1);
+    }
+
+    SUBCASE("stamping after close")
+    {
+        sxs::TraceLog<int> log(filename);
+        log.stamp(0);
+        log.close();
+        CHECK_THROWS_AS(log.stamp(1), const std::runtime_error &);
+    }
+
+    SUBCASE("a log that was never closed")
+    {
+        {
+            sxs::TraceLog<int> log(filename);
+            for (int i = 0; i < 10; ++i)
+                log.stamp(i % 2);
+            // as if the process was killed: the records are in the file, but close() never ran
+            std::filesystem::copy_file(
+                filename, filename + ".crashed", std::filesystem::copy_options::overwrite_existing
+            );
+        }
+        sxs::TraceLogReader<int> crashed_reader(filename + ".crashed");
+        CHECK(!crashed_reader.is_finished());
+        CHECK(crashed_reader.num_records() == 10);
+        CHECK(compile_result(crashed_reader)[{0, 1}].count == 5);
+        std::remove((filename + ".crashed").c_str());
+    }
+
+    SUBCASE("tokens without a name are rejected")
+    {
+        {
+            sxs::TraceLog<sxs::InternedString> log(filename);
+            log.stamp("trace begin");
+        }
+        // corrupt the token of the only record
+        std::FILE *file = std::fopen(filename.c_str(), "r+b");
+        REQUIRE(file != nullptr);
+        const uint32_t bad_token = 0xFFFFFFF0;
+        std::fseek(file, static_cast<long>(sysconf(_SC_PAGESIZE)) + 4, SEEK_SET);
+        std::fwrite(&bad_token, sizeof(bad_token), 1, file);
+        std::fclose(file);
+        CHECK_THROWS_AS(
+            sxs::TraceLogReader<sxs::InternedString>{filename}, const std::runtime_error &
+        );
+    }
+
+    CHECK_THROWS(sxs::TraceLogReader<int>("/nonexistent/sxs_trace_log"));
+    std::remove(filename.c_str());
+}
+
+}  // namespace __sxs_trace_log
+#endif  // SXS_RUN_TESTS
+
+#endif  // SXS_HAS_MMAP
@@ -0,0 +1,43 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019-2025 Tin Yiu Lai (@soraxas)
+ *
+ * This file is part of the project soraxas_toolbox, a collections of utilities
+ * for developing c++ applications.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * The inline tests of soraxas_toolbox/stats.h (and of the headers that serve its stats), which are
+ * built separately from tests_runner.cpp as its sxs::Stats is not the one of
+ * soraxas_toolbox/stats/timing.h. CMake builds this runner once per storage mode of the stats (see
+ * SXS_STATS_BUILD_WITH_SHARDS).
+ */
+
+#define SXS_RUN_TESTS
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#define DOCTEST_CONFIG_TREAT_CHAR_STAR_AS_STRING
+#include "doctest.h"
+
+#include <soraxas_toolbox/stats.h>
+#include <soraxas_toolbox/stats/metrics_server.h>
@@ -27,6 +27,8 @@
  */
 
 #define SXS_RUN_TESTS
+// count heap allocations of the test binary, see stats/alloc_counter.h
+#define SXS_INSTALL_ALLOC_HOOK
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 
@@ -38,11 +40,29 @@
 #include <soraxas_toolbox/format.h>
 #include <soraxas_toolbox/globals.h>
 #include <soraxas_toolbox/metaprogramming.h>
+#include <soraxas_toolbox/npy_writer.h>
+#include <soraxas_toolbox/parallel.h>
 #include <soraxas_toolbox/print_utils.h>
+#include <soraxas_toolbox/stats/alloc_counter.h>
+#include <soraxas_toolbox/stats/baseline.h>
+#include <soraxas_toolbox/stats/chrome_trace.h>
+#include <soraxas_toolbox/stats/concurrent_timer.h>
+#include <soraxas_toolbox/stats/fixed_timer.h>
+#include <soraxas_toolbox/stats/interned_string.h>
+#include <soraxas_toolbox/stats/live_report.h>
+#include <soraxas_toolbox/stats/metrics_server.h>
+#include <soraxas_toolbox/stats/perf_counters.h>
+#include <soraxas_toolbox/stats/profile_zone.h>
+#include <soraxas_toolbox/stats/summary.h>
 #include <soraxas_toolbox/stats/timer.h>
 #include <soraxas_toolbox/stats/token.h>
+#include <soraxas_toolbox/stats/trace_log.h>
 #include <soraxas_toolbox/vector_math.h>
 
+#ifdef HAS_CEREAL_
+#include <soraxas_toolbox/cereal/stats.h>
+#endif
+
 #ifdef HAS_EIGEN_
 #include <soraxas_toolbox/eigen_helpers.h>
 #include <soraxas_toolbox/eigen_math.h>